@@ -3,6 +3,8 @@
 
 namespace Positional::Collision
 {
+	const UInt32 BoundsTree::k_pairBatch;
+
 #pragma region Public
 	UInt32 BoundsTree::add(const Bounds &bounds, const UInt32 &mask)
 	{
@@ -31,7 +33,7 @@ namespace Positional::Collision
 		while (ancestorHandle != NOT_FOUND)
 		{
 			Node &ancestor = m_nodes.at(ancestorHandle);
-			ancestor.mask = m_nodes.at(ancestor.children[0]).mask | m_nodes.at(ancestor.children[0]).mask;
+			ancestor.mask = m_nodes.at(ancestor.children[0]).mask | m_nodes.at(ancestor.children[1]).mask;
 			ancestorHandle = ancestor.parent;
 		}
 	}
@@ -109,47 +111,79 @@ namespace Positional::Collision
 		}
 	}
 
-	void BoundsTree::forEachOverlapPair(const ResultPairCallback &resultsCallback, const bool &exclusive) const
+	void BoundsTree::forEachOverlapPair(const ResultPairCallback &resultsCallback, const bool &exclusive, ITaskScheduler *scheduler) const
 	{
 		if (m_root == NOT_FOUND)
 		{
 			return;
 		}
 
-		unordered_set<HandlePair, HandlePair::SYM_HASH, HandlePair::SYM_EQ> pairs;
-
-		for (const UInt32 &leafHandle : m_leaves)
+		// a pair is reported by whichever of its leaves comes first, so leaves need no shared set of reported pairs
+		const vector<UInt32> leaves(m_leaves.begin(), m_leaves.end());
+		unordered_map<UInt32, UInt32> order;
+		order.reserve(leaves.size());
+		for (UInt32 i = 0, count = leaves.size(); i < count; ++i)
 		{
-			deque<UInt32> stack;
-			stack.push_back(m_root);
+			order[leaves[i]] = i;
+		}
 
+		const auto query = [&, this](const UInt32 &index, const ResultPairCallback &callback)
+		{
+			const UInt32 leafHandle = leaves[index];
 			const Node &leaf = m_nodes.at(leafHandle);
 			const UInt32 mask = leaf.mask;
 			const Bounds &bounds = leaf.bounds;
 
+			vector<UInt32> stack;
+			stack.push_back(m_root);
 			while (stack.size() > 0)
 			{
 				const UInt32 handle = stack.back();
 				stack.pop_back();
 
-				if (handle != leafHandle)
+				const Node &node = m_nodes.at(handle);
+				if (handle == leafHandle || (mask & node.mask) == 0 || (node.isLeaf() && order.at(handle) < index) || !node.bounds.intersects(bounds, exclusive))
 				{
-					const Node &node = m_nodes.at(handle);
-					const HandlePair pair(leafHandle, handle);
-					if ((mask & node.mask) != 0 && pairs.count(pair) == 0 && node.bounds.intersects(bounds, exclusive))
-					{
-						if (node.isLeaf())
-						{
-							pairs.insert(pair);
-							resultsCallback(pair);
-						}
-						else
-						{
-							stack.push_back(node.children[1]);
-							stack.push_back(node.children[0]);
-						}
-					}
+					continue;
 				}
+
+				if (node.isLeaf())
+				{
+					callback(HandlePair(leafHandle, handle));
+				}
+				else
+				{
+					stack.push_back(node.children[1]);
+					stack.push_back(node.children[0]);
+				}
+			}
+		};
+
+		if (scheduler == nullptr || scheduler->threadCount() == 1 || leaves.size() <= k_pairBatch)
+		{
+			for (UInt32 i = 0, count = leaves.size(); i < count; ++i)
+			{
+				query(i, resultsCallback);
+			}
+			return;
+		}
+
+		// query in parallel, then report batch by batch in the order of the serial pass
+		vector<vector<HandlePair>> batches((leaves.size() + k_pairBatch - 1) / k_pairBatch);
+		scheduler->parallelFor(leaves.size(), k_pairBatch, [&](const UInt32 &begin, const UInt32 &end)
+		{
+			vector<HandlePair> &batch = batches[begin / k_pairBatch];
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				query(i, [&](const HandlePair &pair) { batch.push_back(pair); });
+			}
+		});
+
+		for (const vector<HandlePair> &batch : batches)
+		{
+			for (const HandlePair &pair : batch)
+			{
+				resultsCallback(pair);
 			}
 		}
 	}
@@ -264,7 +298,7 @@ namespace Positional::Collision
 
 		while (queue.size() > 0)
 		{
-			const auto &[handle, inheritedCost] = queue.back();
+			const auto [handle, inheritedCost] = queue.back();
 			queue.pop_back();
 
 			if (sa + inheritedCost < bestCost) // low bounds test
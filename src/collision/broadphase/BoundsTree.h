@@ -3,6 +3,7 @@
  */
 #include "math/Math.h"
 #include "data/IdPair.h"
+#include "tasks/ITaskScheduler.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -54,6 +55,8 @@ namespace Positional::Collision
 		unordered_set<UInt32> m_leaves;
 		UInt32 m_nextHandle;
 		UInt32 m_root;
+		// leaves per parallel pair query
+		static const UInt32 k_pairBatch = 32;
 
 		void add(const Bounds &bounds, const UInt32 &mask, const UInt32 &handle);
 		void remove(const UInt32 &handle, const bool &refitAncestors);
@@ -81,7 +84,11 @@ namespace Positional::Collision
 
 		void raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const ResultCallback &resultsCallback) const;
 		void intersects(const Bounds &bounds, const UInt32 &mask, const ResultCallback &resultsCallback, const bool &exclusive = false) const;
-		void forEachOverlapPair(const ResultPairCallback &resultsCallback, const bool &exclusive = false) const;
+		/*
+		 * Reports every overlapping pair of leaves once. With a scheduler the leaves are queried in parallel,
+		 * pairs still arrive on the calling thread and in the same order.
+		 */
+		void forEachOverlapPair(const ResultPairCallback &resultsCallback, const bool &exclusive = false, ITaskScheduler *scheduler = nullptr) const;
 
 		void forEachNode(const function<void(Bounds)> &callback)
 		{
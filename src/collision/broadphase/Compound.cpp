@@ -0,0 +1,120 @@
+#include "Compound.h"
+#include "simulation/Body.h"
+
+namespace Positional::Collision
+{
+	/*
+	 * Tight body space bounds from the collider support along each body axis
+	 */
+	inline Bounds bodyBounds(const Collider &collider)
+	{
+		const Pose &pose = collider.pose;
+		Bounds bounds(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::pos_x))), Vec3::zero);
+		bounds.merge(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::neg_x))));
+		bounds.merge(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::pos_y))));
+		bounds.merge(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::neg_y))));
+		bounds.merge(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::pos_z))));
+		bounds.merge(pose.transform(collider.localSupport(pose.inverseRotate(Vec3::neg_z))));
+		return bounds;
+	}
+
+	const Ref<Collider> &Compound::single() const
+	{
+		assert(m_children.size() == 1);
+		return m_children.begin()->second.collider;
+	}
+
+	void Compound::add(const Ref<Collider> &ref)
+	{
+		const Collider &collider = ref.get();
+		const Bounds bounds = bodyBounds(collider);
+		const UInt32 handle = m_tree.add(bounds, collider.mask);
+		m_children[handle] = {ref, bounds};
+		refresh();
+	}
+
+	bool Compound::remove(const Ref<Collider> &ref)
+	{
+		for (const auto &[handle, child] : m_children)
+		{
+			if (child.collider == ref)
+			{
+				m_tree.remove(handle);
+				m_children.erase(handle);
+				refresh();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Compound::refresh()
+	{
+		m_mask = 0;
+		bool first = true;
+		for (const auto &[handle, child] : m_children)
+		{
+			m_mask |= child.collider.get().mask;
+			if (first)
+			{
+				m_localBounds = child.bounds;
+				first = false;
+			}
+			else
+			{
+				m_localBounds.merge(child.bounds);
+			}
+		}
+	}
+
+	Bounds Compound::bounds() const
+	{
+		const Pose &pose = m_body.get().pose;
+		const Vec3 &e = m_localBounds.extents();
+		const Vec3 x = pose.rotate(Vec3(e.x, 0, 0)).abs();
+		const Vec3 y = pose.rotate(Vec3(0, e.y, 0)).abs();
+		const Vec3 z = pose.rotate(Vec3(0, 0, e.z)).abs();
+		return Bounds(pose.transform(m_localBounds.center), x + y + z);
+	}
+
+	void Compound::intersects(const Bounds &bounds, const UInt32 &mask, const ChildCallback &callback) const
+	{
+		const Pose &pose = m_body.get().pose;
+		const Vec3 &e = bounds.extents();
+		const Vec3 x = pose.inverseRotate(Vec3(e.x, 0, 0)).abs();
+		const Vec3 y = pose.inverseRotate(Vec3(0, e.y, 0)).abs();
+		const Vec3 z = pose.inverseRotate(Vec3(0, 0, e.z)).abs();
+		const Bounds local(pose.inverseTransform(bounds.center), x + y + z);
+
+		m_tree.intersects(
+			local,
+			mask,
+			[&, this](const UInt32 &handle)
+			{
+				callback(m_children.at(handle).collider);
+			});
+	}
+
+	void Compound::raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const ChildCallback &callback) const
+	{
+		const Pose &pose = m_body.get().pose;
+		const Ray local(pose.inverseTransform(ray.origin), pose.inverseRotate(ray.normal()));
+
+		m_tree.raycast(
+			local,
+			mask,
+			maxDistance,
+			[&, this](const UInt32 &handle)
+			{
+				callback(m_children.at(handle).collider);
+			});
+	}
+
+	void Compound::forEachChild(const ChildCallback &callback) const
+	{
+		for (const auto &[handle, child] : m_children)
+		{
+			callback(child.collider);
+		}
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * All colliders of one body grouped behind a single broadphase proxy.
+ * Children are kept in a small bounds tree in body space, which stays valid while the body moves.
+ */
+#ifndef COMPOUND_H
+#define COMPOUND_H
+
+#include "BoundsTree.h"
+#include "collision/collider/Collider.h"
+#include "data/Store.h"
+#include "math/Math.h"
+
+using namespace std;
+
+namespace Positional
+{
+	struct Body;
+}
+
+namespace Positional::Collision
+{
+	typedef function<void(const Ref<Collider> &)> ChildCallback;
+
+	class Compound
+	{
+	private:
+		struct Child
+		{
+			Ref<Collider> collider;
+			// body space
+			Bounds bounds;
+		};
+
+		Ref<Body> m_body;
+		BoundsTree m_tree;
+		// tree handle to child
+		unordered_map<UInt32, Child> m_children;
+		Bounds m_localBounds;
+		UInt32 m_mask;
+
+		void refresh();
+
+	public:
+		Compound() : m_mask(0) {}
+		Compound(const Ref<Body> &body) : m_body(body), m_mask(0) {}
+
+		inline const Ref<Body> &body() const { return m_body; }
+		inline UInt32 count() const { return m_children.size(); }
+		inline bool empty() const { return m_children.empty(); }
+
+		/*
+		 * Union of the child masks
+		 */
+		inline UInt32 mask() const { return m_mask; }
+
+		/*
+		 * The only child, valid when count() == 1
+		 */
+		const Ref<Collider> &single() const;
+
+		void add(const Ref<Collider> &collider);
+		bool remove(const Ref<Collider> &collider);
+
+		/*
+		 * World space bounds of all children
+		 */
+		Bounds bounds() const;
+
+		/*
+		 * Calls back with each child whose bounds intersect the world space bounds
+		 */
+		void intersects(const Bounds &bounds, const UInt32 &mask, const ChildCallback &callback) const;
+
+		/*
+		 * Calls back with each child whose bounds are hit by the world space ray
+		 */
+		void raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const ChildCallback &callback) const;
+
+		void forEachChild(const ChildCallback &callback) const;
+	};
+}
+
+#endif // COMPOUND_H
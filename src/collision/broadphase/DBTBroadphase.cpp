@@ -3,14 +3,12 @@
 
 namespace Positional::Collision
 {
+	const UInt32 DBTBroadphase::k_batchSize;
+
 #pragma region ABroadphase Interface
 	void DBTBroadphase::add(const Ref<Collider> &ref)
 	{
-		const Collider &collider = ref.get();
-		const Bounds &bounds = collider.bounds();
-		Bounds treeBounds = Bounds(bounds.center, bounds.extents() * m_padFactor);
-		UInt32 handle = m_dynamicTree.add(treeBounds, collider.mask);
-		m_dynamicNodes[handle] = Node(ref, treeBounds);
+		addCompound(m_dynamicTree, m_dynamicNodes, m_bodyHandles, ref);
 	}
 
 	void DBTBroadphase::addStatic(const Ref<Collider> &ref)
@@ -23,12 +21,7 @@ namespace Positional::Collision
 
 	void DBTBroadphase::remove(const Ref<Collider> &ref)
 	{
-		UInt32 handle = find(m_dynamicNodes, ref);
-		if (handle != NOT_FOUND)
-		{
-			m_dynamicTree.remove(handle);
-			m_dynamicNodes.erase(handle);
-		}
+		removeCompound(m_dynamicTree, m_dynamicNodes, m_bodyHandles, ref);
 	}
 
 	void DBTBroadphase::removeStatic(const Ref<Collider> &ref)
@@ -41,21 +34,20 @@ namespace Positional::Collision
 		}
 	}
 
-	void DBTBroadphase::update(const Float &dt)
+	void DBTBroadphase::addKinematic(const Ref<Collider> &ref)
 	{
-		for (auto &[handle, node] : m_dynamicNodes)
-		{
-			const Collider &collider = node.collider.get();
-			const Bounds &bounds = collider.bounds();
-			const Bounds predictedBounds = Bounds(bounds.center + m_padFactor * dt * collider.body().get().velocity.linear, bounds.extents());
+		addCompound(m_kinematicTree, m_kinematicNodes, m_kinematicHandles, ref);
+	}
 
-			if (!node.treeBounds.contains(predictedBounds))
-			{
-				node.treeBounds = bounds.merged(predictedBounds);
-				node.treeBounds.expand(bounds.extents() * (m_padFactor * 0.5));
-				m_dynamicTree.update(handle, node.treeBounds, collider.mask);
-			}
-		}
+	void DBTBroadphase::removeKinematic(const Ref<Collider> &ref)
+	{
+		removeCompound(m_kinematicTree, m_kinematicNodes, m_kinematicHandles, ref);
+	}
+
+	void DBTBroadphase::update(const Float &dt)
+	{
+		updateCompounds(m_dynamicTree, m_dynamicNodes, dt);
+		updateCompounds(m_kinematicTree, m_kinematicNodes, dt);
 
 		// TODO: update static tree only when it is dirty
 		for (auto &[handle, node] : m_staticNodes)
@@ -71,6 +63,65 @@ namespace Positional::Collision
 		}
 	}
 
+	void DBTBroadphase::updateCompounds(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, const Float &dt)
+	{
+		m_updateNodes.clear();
+		for (auto &[handle, node] : nodes)
+		{
+			m_updateNodes.push_back(make_pair(handle, &node));
+		}
+		m_moved.assign(m_updateNodes.size(), 0);
+
+		// proxies are independent, only the tree update below is shared
+		const RangeCallback predict = [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				CompoundNode &node = *m_updateNodes[i].second;
+				const Body &body = node.compound.body().get();
+				// sleeping bodies do not move, their proxies stay frozen
+				if (body.isSleeping())
+				{
+					continue;
+				}
+
+				Bounds bounds = node.compound.bounds();
+				node.displacement = m_padFactor * dt * body.velocity.linear;
+				if (body.ccd)
+				{
+					// sweep the whole step including the corners swinging out from rotation
+					bounds.expand(dt * body.velocity.angular.length() * bounds.extents().length());
+				}
+				const Bounds predictedBounds = Bounds(bounds.center + node.displacement, bounds.extents());
+
+				if (!node.treeBounds.contains(predictedBounds))
+				{
+					node.treeBounds = bounds.merged(predictedBounds);
+					node.treeBounds.expand(bounds.extents() * (m_padFactor * 0.5));
+					m_moved[i] = 1;
+				}
+			}
+		};
+
+		if (m_scheduler != nullptr)
+		{
+			m_scheduler->parallelFor(m_updateNodes.size(), k_batchSize, predict);
+		}
+		else
+		{
+			predict(0, m_updateNodes.size());
+		}
+
+		for (UInt32 i = 0, count = m_updateNodes.size(); i < count; ++i)
+		{
+			if (m_moved[i] != 0)
+			{
+				const auto &[handle, node] = m_updateNodes[i];
+				tree.update(handle, node->treeBounds, node->compound.mask());
+			}
+		}
+	}
+
 	void DBTBroadphase::raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const RaycastCallback &callback) const
 	{
 		m_dynamicTree.raycast(
@@ -79,8 +130,8 @@ namespace Positional::Collision
 			maxDistance,
 			[&](const UInt32 &handle)
 			{
-				const Node &node = m_dynamicNodes.at(handle);
-				callback(node.collider);
+				const CompoundNode &node = m_dynamicNodes.at(handle);
+				node.compound.raycast(ray, mask, maxDistance, callback);
 			});
 
 		m_staticTree.raycast(
@@ -92,6 +143,16 @@ namespace Positional::Collision
 				const Node &node = m_staticNodes.at(handle);
 				callback(node.collider);
 			});
+
+		m_kinematicTree.raycast(
+			ray,
+			mask,
+			maxDistance,
+			[&](const UInt32 &handle)
+			{
+				const CompoundNode &node = m_kinematicNodes.at(handle);
+				node.compound.raycast(ray, mask, maxDistance, callback);
+			});
 	}
 
 	void DBTBroadphase::forEachOverlapPair(const OverlapCallback &callback) const
@@ -99,28 +160,145 @@ namespace Positional::Collision
 		m_dynamicTree.forEachOverlapPair(
 			[&, this](const auto &pair)
 			{
-				const Node &node1 = m_dynamicNodes.at(pair.first);
-				const Node &node2 = m_dynamicNodes.at(pair.second);
-				// TODO: find better way to check for colliders with the same body, possibly need to implement compound collider
-				if (node1.collider.get().body() != node2.collider.get().body())
-				{
-					callback(make_pair(node1.collider, node2.collider));
-				}
+				forEachChildPair(m_dynamicNodes.at(pair.first), m_dynamicNodes.at(pair.second), callback);
 			},
-			false);
+			false,
+			m_scheduler);
+
+		// kinematic proxies are few, each queries the dynamic tree whether it sleeps or not
+		for (const auto &[handle, kinematic] : m_kinematicNodes)
+		{
+			m_dynamicTree.intersects(
+				kinematic.treeBounds,
+				kinematic.compound.mask(),
+				[&, this](const UInt32 &dynamicHandle)
+				{
+					forEachChildPair(m_dynamicNodes.at(dynamicHandle), kinematic, callback);
+				});
+		}
 
+		vector<const CompoundNode *> nodes;
+		nodes.reserve(m_dynamicNodes.size());
 		for (const auto &[handle, node] : m_dynamicNodes)
 		{
-			auto ref = node.collider;
-			const Collider &collider = ref.get();
+			if (!node.compound.body().get().isSleeping())
+			{
+				nodes.push_back(&node);
+			}
+		}
+
+		const auto queryStatic = [&, this](const CompoundNode &node, const OverlapCallback &pairCallback)
+		{
 			m_staticTree.intersects(
 				node.treeBounds,
-				collider.mask,
+				node.compound.mask(),
 				[&, this](const UInt32 &handle)
 				{
-					const Node &staticNode = m_staticNodes.at(handle);
-					callback(make_pair(ref, staticNode.collider));
+					forEachChildPair(node, m_staticNodes.at(handle), pairCallback);
 				});
+		};
+
+		if (m_scheduler == nullptr || m_scheduler->threadCount() == 1 || nodes.size() <= k_batchSize)
+		{
+			for (const CompoundNode *node : nodes)
+			{
+				queryStatic(*node, callback);
+			}
+			return;
+		}
+
+		// query in parallel, then report batch by batch so the order does not depend on the threads
+		vector<vector<pair<Ref<Collider>, Ref<Collider>>>> batches((nodes.size() + k_batchSize - 1) / k_batchSize);
+		m_scheduler->parallelFor(nodes.size(), k_batchSize, [&](const UInt32 &begin, const UInt32 &end)
+		{
+			auto &batch = batches[begin / k_batchSize];
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				queryStatic(*nodes[i], [&](const pair<Ref<Collider>, Ref<Collider>> &pair) { batch.push_back(pair); });
+			}
+		});
+
+		for (const auto &batch : batches)
+		{
+			for (const auto &pair : batch)
+			{
+				callback(pair);
+			}
+		}
+	}
+
+	void DBTBroadphase::intersectsStatic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const
+	{
+		m_staticTree.intersects(bounds, mask, [&](const UInt32 &handle)
+		{
+			callback(m_staticNodes.at(handle).collider);
+		});
+	}
+
+	void DBTBroadphase::intersectsDynamic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const
+	{
+		m_dynamicTree.intersects(bounds, mask, [&](const UInt32 &handle)
+		{
+			m_dynamicNodes.at(handle).compound.intersects(bounds, mask, callback);
+		});
+
+		m_kinematicTree.intersects(bounds, mask, [&](const UInt32 &handle)
+		{
+			m_kinematicNodes.at(handle).compound.intersects(bounds, mask, callback);
+		});
+	}
+
+	/*
+	 * Adds the collider to the proxy of its body in tree, creating the proxy for the first collider of a body
+	 */
+	void DBTBroadphase::addCompound(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, unordered_map<UInt64, UInt32> &handles, const Ref<Collider> &ref)
+	{
+		const Ref<Body> &body = ref.get().body();
+		const auto it = handles.find(body.id());
+		if (it == handles.end())
+		{
+			CompoundNode node(body);
+			node.compound.add(ref);
+			const Bounds bounds = node.compound.bounds();
+			node.treeBounds = Bounds(bounds.center, bounds.extents() * m_padFactor);
+			UInt32 handle = tree.add(node.treeBounds, node.compound.mask());
+			nodes[handle] = node;
+			handles[body.id()] = handle;
+		}
+		else
+		{
+			CompoundNode &node = nodes.at(it->second);
+			node.compound.add(ref);
+			const Bounds bounds = node.compound.bounds();
+			node.treeBounds = Bounds(bounds.center, bounds.extents() * m_padFactor);
+			tree.update(it->second, node.treeBounds, node.compound.mask());
+		}
+	}
+
+	void DBTBroadphase::removeCompound(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, unordered_map<UInt64, UInt32> &handles, const Ref<Collider> &ref)
+	{
+		const auto it = handles.find(ref.get().body().id());
+		if (it == handles.end())
+		{
+			return;
+		}
+
+		const UInt32 handle = it->second;
+		CompoundNode &node = nodes.at(handle);
+		if (!node.compound.remove(ref))
+		{
+			return;
+		}
+
+		if (node.compound.empty())
+		{
+			tree.remove(handle);
+			nodes.erase(handle);
+			handles.erase(it);
+		}
+		else
+		{
+			tree.updateMask(handle, node.compound.mask());
 		}
 	}
 
@@ -136,4 +314,62 @@ namespace Positional::Collision
 		return NOT_FOUND;
 	}
 #pragma endregion ABroadphase Interface
+
+#pragma region Compounds
+	/*
+	 * Child bounds padded like the tree bounds and extended over the predicted movement
+	 */
+	Bounds DBTBroadphase::swept(const Bounds &bounds, const Vec3 &displacement) const
+	{
+		const Bounds padded(bounds.center, bounds.extents() * m_padFactor);
+		return padded.merged(Bounds(padded.center + displacement, padded.extents()));
+	}
+
+	void DBTBroadphase::forEachChildPair(const CompoundNode &a, const CompoundNode &b, const OverlapCallback &callback) const
+	{
+		// the tree already tested the proxies
+		if (a.compound.count() == 1 && b.compound.count() == 1)
+		{
+			callback(make_pair(a.compound.single(), b.compound.single()));
+			return;
+		}
+
+		// query the children of the larger compound with those of the smaller
+		const bool swap = a.compound.count() > b.compound.count();
+		const CompoundNode &small = swap ? b : a;
+		const CompoundNode &large = swap ? a : b;
+		const Vec3 displacement = small.displacement - large.displacement;
+
+		small.compound.forEachChild([&, this](const Ref<Collider> &smallChild)
+		{
+			const Collider &collider = smallChild.get();
+			large.compound.intersects(
+				swept(collider.bounds(), displacement),
+				collider.mask,
+				[&](const Ref<Collider> &largeChild)
+				{
+					callback(swap ? make_pair(largeChild, smallChild) : make_pair(smallChild, largeChild));
+				});
+		});
+	}
+
+	void DBTBroadphase::forEachChildPair(const CompoundNode &a, const Node &b, const OverlapCallback &callback) const
+	{
+		if (a.compound.count() == 1)
+		{
+			callback(make_pair(a.compound.single(), b.collider));
+			return;
+		}
+
+		const UInt32 mask = b.collider.get().mask;
+		a.compound.forEachChild([&, this](const Ref<Collider> &child)
+		{
+			const Collider &collider = child.get();
+			if ((collider.mask & mask) != 0 && swept(collider.bounds(), a.displacement).intersects(b.treeBounds))
+			{
+				callback(make_pair(child, b.collider));
+			}
+		});
+	}
+#pragma endregion // Compounds
 }
\ No newline at end of file
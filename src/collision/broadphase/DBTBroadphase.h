@@ -6,7 +6,9 @@
 
 #include "IBroadphase.h"
 #include "BoundsTree.h"
+#include "Compound.h"
 #include "math/Math.h"
+#include "tasks/ITaskScheduler.h"
 #include <optional>
 
 using namespace std;
@@ -31,16 +33,56 @@ namespace Positional::Collision
 				treeBounds(_treeBounds) {}
 		};
 
+		/*
+		 * One proxy per dynamic body, colliders of the same body never pair with each other
+		 */
+		class CompoundNode
+		{
+		public:
+			Compound compound;
+			Bounds treeBounds;
+			// predicted movement over the last update
+			Vec3 displacement;
+
+			CompoundNode() :
+				treeBounds(Bounds(Vec3::zero, Vec3::zero)),
+				displacement(Vec3::zero) {}
+
+			CompoundNode(const Ref<Body> &body) :
+				compound(body),
+				treeBounds(Bounds(Vec3::zero, Vec3::zero)),
+				displacement(Vec3::zero) {}
+		};
+
 		BoundsTree m_dynamicTree;
 		BoundsTree m_staticTree;
-		unordered_map<UInt32, Node> m_dynamicNodes;
+		// kinematic bodies only query the dynamic tree, so they never pair with static colliders or each other
+		BoundsTree m_kinematicTree;
+		unordered_map<UInt32, CompoundNode> m_dynamicNodes;
 		unordered_map<UInt32, Node> m_staticNodes;
+		unordered_map<UInt32, CompoundNode> m_kinematicNodes;
+		// body id to dynamic and kinematic tree handle
+		unordered_map<UInt64, UInt32> m_bodyHandles;
+		unordered_map<UInt64, UInt32> m_kinematicHandles;
 		Float m_padFactor;
+		// optional, runs the per body work in parallel
+		ITaskScheduler *m_scheduler;
+		static const UInt32 k_batchSize = 32;
+
+		// per update scratch, proxies in map order and whether their tree bounds changed
+		vector<pair<UInt32, CompoundNode *>> m_updateNodes;
+		vector<UInt8> m_moved;
 
 		UInt32 find(const unordered_map<UInt32, Node> &nodeMap, const Ref<Collider> &collider) const;
+		void addCompound(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, unordered_map<UInt64, UInt32> &handles, const Ref<Collider> &collider);
+		void removeCompound(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, unordered_map<UInt64, UInt32> &handles, const Ref<Collider> &collider);
+		void updateCompounds(BoundsTree &tree, unordered_map<UInt32, CompoundNode> &nodes, const Float &dt);
+		Bounds swept(const Bounds &bounds, const Vec3 &displacement) const;
+		void forEachChildPair(const CompoundNode &a, const CompoundNode &b, const OverlapCallback &callback) const;
+		void forEachChildPair(const CompoundNode &a, const Node &b, const OverlapCallback &callback) const;
 
 	public:
-		DBTBroadphase(const Float &padFactor = 2.0) : m_padFactor(padFactor) {}
+		DBTBroadphase(const Float &padFactor = 2.0, ITaskScheduler *scheduler = nullptr) : m_padFactor(padFactor), m_scheduler(scheduler) {}
 		~DBTBroadphase() {}
 
 #pragma region ABroadphase Interface
@@ -48,16 +90,21 @@ namespace Positional::Collision
 		virtual void addStatic(const Ref<Collider> &collider) override;
 		virtual void remove(const Ref<Collider> &collider) override;
 		virtual void removeStatic(const Ref<Collider> &collider) override;
+		virtual void addKinematic(const Ref<Collider> &collider) override;
+		virtual void removeKinematic(const Ref<Collider> &collider) override;
 		virtual void update(const Float &dt) override;
 
 		virtual void raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const RaycastCallback &callback) const override;
 		virtual void forEachOverlapPair(const OverlapCallback &callback) const override;
+		virtual void intersectsStatic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const override;
+		virtual void intersectsDynamic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const override;
 #pragma endregion ABroadphase Interface
 
 		void forEachNode(const function<void(Bounds)> &callback)
 		{
 			m_dynamicTree.forEachNode(callback);
 			m_staticTree.forEachNode(callback);
+			m_kinematicTree.forEachNode(callback);
 		}
 	};
 }
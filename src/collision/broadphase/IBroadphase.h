@@ -13,6 +13,7 @@ using namespace std;
 namespace Positional::Collision
 {
 	typedef function<void(const Ref<Collider> &)> RaycastCallback;
+	typedef function<void(const Ref<Collider> &)> QueryCallback;
 	typedef function<void(const pair<Ref<Collider>, Ref<Collider>> &)> OverlapCallback;
 
 	class IBroadphase
@@ -23,10 +24,26 @@ namespace Positional::Collision
 		virtual void addStatic(const Ref<Collider> &collider) = 0;
 		virtual void remove(const Ref<Collider> &collider) = 0;
 		virtual void removeStatic(const Ref<Collider> &collider) = 0;
+
+		/*
+		 * Colliders of kinematic bodies pair with those of dynamic bodies only, never with static or other kinematic colliders
+		 */
+		virtual void addKinematic(const Ref<Collider> &collider) = 0;
+		virtual void removeKinematic(const Ref<Collider> &collider) = 0;
 		virtual void update(const Float &dt) = 0;
 
 		virtual void raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const RaycastCallback &callback) const = 0;
 		virtual void forEachOverlapPair(const OverlapCallback &callback) const = 0;
+
+		/*
+		 * Static colliders whose bounds overlap bounds, safe to call from several threads while nothing is added or removed
+		 */
+		virtual void intersectsStatic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const = 0;
+
+		/*
+		 * Colliders of dynamic and kinematic bodies whose bounds overlap bounds, with the same threading rules as intersectsStatic
+		 */
+		virtual void intersectsDynamic(const Bounds &bounds, const UInt32 &mask, const QueryCallback &callback) const = 0;
 	};
 }
 #endif // IBROADPHASE_H
@@ -4,8 +4,48 @@
 
 namespace Positional
 {
+	void Collider::beginStep(const Body *body)
+	{
+		m_stepBody = body;
+		m_cached = true;
+		updateWorldTransform();
+	}
+
+	void Collider::updateWorldTransform() const
+	{
+		// linear poses ignore their rotation
+		const Quat rotation = pose.usesRotation ? pose.rotation : Quat();
+		if (m_stepBody != nullptr)
+		{
+			const Pose &bodyPose = m_stepBody->pose;
+			m_world.rotation = Mat3x3(bodyPose.usesRotation ? bodyPose.rotation * rotation : rotation);
+			m_world.position = bodyPose.transform(pose.position);
+			m_world.version = m_stepBody->poseVersion();
+		}
+		else
+		{
+			m_world.rotation = Mat3x3(rotation);
+			m_world.position = pose.position;
+		}
+	}
+
+	const Collider::WorldTransform &Collider::worldTransform() const
+	{
+		if (m_stepBody != nullptr && m_stepBody->poseVersion() != m_world.version)
+		{
+			updateWorldTransform();
+		}
+		return m_world;
+	}
+
 	Vec3 Collider::pointToWorld(const Vec3 &point) const
 	{
+		if (m_cached)
+		{
+			const WorldTransform &world = worldTransform();
+			return point * world.rotation + world.position;
+		}
+
 		Vec3 bodySpace = pose.transform(point);
 		if (m_body.valid())
 		{
@@ -16,6 +56,11 @@ namespace Positional
 
 	Vec3 Collider::vectorToWorld(const Vec3 &vector) const
 	{
+		if (m_cached)
+		{
+			return vector * worldTransform().rotation;
+		}
+
 		Vec3 bodySpace = pose.rotate(vector);
 		if (m_body.valid())
 		{
@@ -26,13 +71,42 @@ namespace Positional
 
 	Vec3 Collider::pointToLocal(const Vec3 &point) const
 	{
+		if (m_cached)
+		{
+			const WorldTransform &world = worldTransform();
+			return world.rotation * (point - world.position);
+		}
+
 		Vec3 bodySpace = m_body.valid() ? m_body.get().pose.inverseTransform(point) : point;
 		return pose.inverseTransform(bodySpace);
 	}
 
 	Vec3 Collider::vectorToLocal(const Vec3 &vector) const
 	{
+		if (m_cached)
+		{
+			return worldTransform().rotation * vector;
+		}
+
 		Vec3 bodySpace = m_body.valid() ? m_body.get().pose.inverseRotate(vector) : vector;
 		return pose.inverseRotate(bodySpace);
 	}
+
+	Bounds Collider::boundsToWorld(const Bounds &bounds) const
+	{
+		const Vec3 &e = bounds.extents();
+		const Vec3 x = vectorToWorld(Vec3(e.x, 0, 0)).abs();
+		const Vec3 y = vectorToWorld(Vec3(0, e.y, 0)).abs();
+		const Vec3 z = vectorToWorld(Vec3(0, 0, e.z)).abs();
+		return Bounds(pointToWorld(bounds.center), x + y + z);
+	}
+
+	Bounds Collider::boundsToLocal(const Bounds &bounds) const
+	{
+		const Vec3 &e = bounds.extents();
+		const Vec3 x = vectorToLocal(Vec3(e.x, 0, 0)).abs();
+		const Vec3 y = vectorToLocal(Vec3(0, e.y, 0)).abs();
+		const Vec3 z = vectorToLocal(Vec3(0, 0, e.z)).abs();
+		return Bounds(pointToLocal(bounds.center), x + y + z);
+	}
 }
\ No newline at end of file
@@ -27,7 +27,7 @@ namespace Positional
 			Float radius;
 			Float length;
 		};
-		void* mesh; // placeholder for mesh pointer
+		void* mesh; // shared shape data, e.g. ConvexHull
 
 		Shape() : extents(Vec3::zero)
 		{
@@ -66,9 +66,35 @@ namespace Positional
 
 	struct Collider final
 	{
+		friend class World;
 	private:
 		Ref<Body> m_body;
 		bool m_isStatic;
+
+		/*
+		 * World transform cached while a step runs, rotate with point * rotation and inverse rotate with rotation * point.
+		 * Rebuilt on first use after the body's pose version changed.
+		 */
+		struct WorldTransform
+		{
+			Mat3x3 rotation;
+			Vec3 position;
+			UInt32 version;
+		};
+		mutable WorldTransform m_world;
+		// resolved for the step, nullptr for static colliders
+		const Body *m_stepBody;
+		bool m_cached;
+
+		void updateWorldTransform() const;
+		const WorldTransform &worldTransform() const;
+
+		/*
+		 * Turns the cache on for a step, body stays valid until endStep
+		 */
+		void beginStep(const Body *body);
+		inline void endStep() { m_cached = false; m_stepBody = nullptr; }
+
 		UInt8 m_shapeId;
 		Bounds(*m_bounds)(const Collider &);
 		Float(*m_volume)(const Collider &);
@@ -95,6 +121,8 @@ namespace Positional
 		) :
 			m_body(body),
 			m_isStatic(!body.valid()),
+			m_stepBody(nullptr),
+			m_cached(false),
 			m_shapeId(shapeId),
 			m_bounds(bounds),
 			m_volume(volume),
@@ -165,6 +193,18 @@ namespace Positional
 		Vec3 pointToLocal(const Vec3 &point) const;
 		Vec3 vectorToLocal(const Vec3 &vector) const;
 
+		/*
+		 * Points in the space of the collider's body, world space for static colliders
+		 */
+		inline Vec3 localToBody(const Vec3 &point) const { return m_isStatic ? pointToWorld(point) : pose.transform(point); }
+		inline Vec3 worldToBody(const Vec3 &point) const { return m_isStatic ? point : pose.transform(pointToLocal(point)); }
+
+		/*
+		 * Axis aligned bounds enclosing the transformed box
+		 */
+		Bounds boundsToWorld(const Bounds &bounds) const;
+		Bounds boundsToLocal(const Bounds &bounds) const;
+
 		static inline void support(const Collider &a, const Collider &b, const Vec3 &axis, Vec3 &outSupport, Vec3 &outSupportA, Vec3 &outSupportB)
 		{
 			const Vec3 axisA = a.vectorToLocal(axis);
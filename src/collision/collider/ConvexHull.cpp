@@ -0,0 +1,390 @@
+#include "ConvexHull.h"
+#include "mass/Volume.h"
+#include <algorithm>
+#include <functional>
+
+namespace Positional
+{
+	const Float ConvexHull::k_quantizeScale = 32767.0;
+
+#pragma region Construction
+	struct HullFace
+	{
+		UInt32 v[3];
+		Vec3 normal;
+		Float distance;
+		bool alive;
+
+		HullFace(const vector<Vec3> &points, const UInt32 &a, const UInt32 &b, const UInt32 &c) : alive(true)
+		{
+			v[0] = a;
+			v[1] = b;
+			v[2] = c;
+			normal = GeomUtil::normal(points[a], points[b], points[c]).normalize();
+			distance = normal.dot(points[a]);
+		}
+
+		inline Float distanceTo(const Vec3 &point) const { return normal.dot(point) - distance; }
+	};
+
+	inline UInt32 farthestFrom(const vector<Vec3> &points, const function<Float(const Vec3 &)> &distance, Float &outDistance)
+	{
+		UInt32 best = 0;
+		outDistance = -FLOAT_MAX;
+		for (UInt32 i = 0, count = points.size(); i < count; ++i)
+		{
+			const Float d = distance(points[i]);
+			if (d > outDistance)
+			{
+				outDistance = d;
+				best = i;
+			}
+		}
+		return best;
+	}
+
+	/*
+	 * Incremental hull. Build time is O(n * faces) which is fine for shapes built once at load time.
+	 */
+	shared_ptr<ConvexHull> ConvexHull::create(const vector<Vec3> &points)
+	{
+		if (points.size() < 4)
+		{
+			return nullptr;
+		}
+
+		Bounds extents(points[0], Vec3::zero);
+		for (const Vec3 &p : points)
+		{
+			extents.merge(p);
+		}
+		const Vec3 &e = extents.extents();
+		const Float eps = Math::max(Math::max(e.x, e.y), e.z) * 0.000001;
+
+		// initial tetrahedron from extreme points
+		Float d;
+		const UInt32 i0 = farthestFrom(points, [&](const Vec3 &p) { return -p.x; }, d);
+		const UInt32 i1 = farthestFrom(points, [&](const Vec3 &p) { return p.distanceSq(points[i0]); }, d);
+		if (d <= eps * eps)
+		{
+			return nullptr;
+		}
+
+		const UInt32 i2 = farthestFrom(points, [&](const Vec3 &p) { return p.distanceSq(GeomUtil::nearestOnSegment(p, points[i0], points[i1])); }, d);
+		if (d <= eps * eps)
+		{
+			return nullptr;
+		}
+
+		const Vec3 n = GeomUtil::normal(points[i0], points[i1], points[i2]).normalize();
+		const UInt32 i3 = farthestFrom(points, [&](const Vec3 &p) { return Math::abs(n.dot(p - points[i0])); }, d);
+		if (d <= eps)
+		{
+			return nullptr;
+		}
+
+		vector<HullFace> faces;
+		if (n.dot(points[i3] - points[i0]) > 0)
+		{
+			faces.push_back(HullFace(points, i0, i2, i1));
+			faces.push_back(HullFace(points, i0, i1, i3));
+			faces.push_back(HullFace(points, i1, i2, i3));
+			faces.push_back(HullFace(points, i2, i0, i3));
+		}
+		else
+		{
+			faces.push_back(HullFace(points, i0, i1, i2));
+			faces.push_back(HullFace(points, i1, i0, i3));
+			faces.push_back(HullFace(points, i2, i1, i3));
+			faces.push_back(HullFace(points, i0, i2, i3));
+		}
+
+		vector<pair<UInt32, UInt32>> edges;
+		for (UInt32 i = 0, count = points.size(); i < count; ++i)
+		{
+			if (i == i0 || i == i1 || i == i2 || i == i3)
+			{
+				continue;
+			}
+
+			// collect edges of faces visible from the point
+			edges.clear();
+			const Vec3 &p = points[i];
+			for (HullFace &face : faces)
+			{
+				if (face.alive && face.distanceTo(p) > eps)
+				{
+					face.alive = false;
+					edges.push_back(make_pair(face.v[0], face.v[1]));
+					edges.push_back(make_pair(face.v[1], face.v[2]));
+					edges.push_back(make_pair(face.v[2], face.v[0]));
+				}
+			}
+
+			// horizon edges are those without a reversed twin, connect them to the new point
+			for (UInt32 j = 0, edgeCount = edges.size(); j < edgeCount; ++j)
+			{
+				bool horizon = true;
+				for (UInt32 k = 0; k < edgeCount; ++k)
+				{
+					if (edges[k].first == edges[j].second && edges[k].second == edges[j].first)
+					{
+						horizon = false;
+						break;
+					}
+				}
+
+				if (horizon)
+				{
+					faces.push_back(HullFace(points, edges[j].first, edges[j].second, i));
+				}
+			}
+		}
+
+		// compact to the vertices used by the hull
+		vector<UInt32> remap(points.size(), NOT_FOUND);
+		vector<Vec3> vertices;
+		vector<UInt32> triangles;
+		for (const HullFace &face : faces)
+		{
+			if (!face.alive)
+			{
+				continue;
+			}
+
+			for (UInt32 j = 0; j < 3; ++j)
+			{
+				if (remap[face.v[j]] == NOT_FOUND)
+				{
+					remap[face.v[j]] = vertices.size();
+					vertices.push_back(points[face.v[j]]);
+				}
+				triangles.push_back(remap[face.v[j]]);
+			}
+		}
+
+		auto hull = shared_ptr<ConvexHull>(new ConvexHull());
+		hull->build(vertices, triangles);
+		return hull;
+	}
+
+	void ConvexHull::build(const vector<Vec3> &vertices, const vector<UInt32> &triangles)
+	{
+		const UInt32 vertexCount = vertices.size();
+
+		// quantize relative to the bounds
+		Bounds bounds(vertices[0], Vec3::zero);
+		for (const Vec3 &v : vertices)
+		{
+			bounds.merge(v);
+		}
+		const Vec3 &e = bounds.extents();
+		m_bounds = bounds;
+		m_dequantize = e / k_quantizeScale;
+
+		vector<Vec3> dequantized(vertexCount);
+		m_vertices.resize(vertexCount);
+		for (UInt32 i = 0; i < vertexCount; ++i)
+		{
+			const Vec3 q = (vertices[i] - bounds.center) / m_dequantize;
+			m_vertices[i] = {
+				(Int16)Math::floor(q.x + 0.5),
+				(Int16)Math::floor(q.y + 0.5),
+				(Int16)Math::floor(q.z + 0.5)};
+			dequantized[i] = vertex(i);
+		}
+
+		m_triangles = triangles;
+
+		// vertex adjacency from triangle edges
+		vector<vector<UInt32>> neighbors(vertexCount);
+		const auto link = [&](const UInt32 &a, const UInt32 &b)
+		{
+			auto &list = neighbors[a];
+			if (find(list.begin(), list.end(), b) == list.end())
+			{
+				list.push_back(b);
+			}
+		};
+
+		for (UInt32 i = 0, count = triangles.size(); i < count; i += 3)
+		{
+			const UInt32 a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+			link(a, b);
+			link(b, a);
+			link(b, c);
+			link(c, b);
+			link(c, a);
+			link(a, c);
+		}
+
+		m_adjacencyOffsets.resize(vertexCount + 1);
+		m_adjacency.clear();
+		for (UInt32 i = 0; i < vertexCount; ++i)
+		{
+			m_adjacencyOffsets[i] = m_adjacency.size();
+			m_adjacency.insert(m_adjacency.end(), neighbors[i].begin(), neighbors[i].end());
+		}
+		m_adjacencyOffsets[vertexCount] = m_adjacency.size();
+
+		// face planes, merging coplanar triangles
+		const Float eps = Math::max(Math::max(e.x, e.y), e.z) * 0.000001;
+		m_planeNormals.clear();
+		m_planeDistances.clear();
+		for (UInt32 i = 0, count = triangles.size(); i < count; i += 3)
+		{
+			const Vec3 n = GeomUtil::normal(dequantized[triangles[i]], dequantized[triangles[i + 1]], dequantized[triangles[i + 2]]).normalize();
+			const Float d = n.dot(dequantized[triangles[i]]);
+
+			bool merged = false;
+			for (UInt32 j = 0, planeCount = m_planeNormals.size(); j < planeCount; ++j)
+			{
+				if (m_planeNormals[j].dot(n) > 0.999999 && Math::approx(m_planeDistances[j], d, eps))
+				{
+					merged = true;
+					break;
+				}
+			}
+
+			if (!merged)
+			{
+				m_planeNormals.push_back(n);
+				m_planeDistances.push_back(d);
+			}
+		}
+
+		// hill climbing start points
+		static const Vec3 axes[6] = {Vec3::neg_x, Vec3::pos_x, Vec3::neg_y, Vec3::pos_y, Vec3::neg_z, Vec3::pos_z};
+		for (UInt32 a = 0; a < 6; ++a)
+		{
+			Float best = -FLOAT_MAX;
+			for (UInt32 i = 0; i < vertexCount; ++i)
+			{
+				const Float d = axes[a].dot(dequantized[i]);
+				if (d > best)
+				{
+					best = d;
+					m_extremes[a] = i;
+				}
+			}
+		}
+
+		m_volume = Volume::polyhedron(dequantized.data(), m_triangles.data(), triangleCount());
+		m_mass.setPolyhedron(dequantized.data(), m_triangles.data(), triangleCount(), 1.0);
+	}
+#pragma endregion // Construction
+
+#pragma region Queries
+	UInt32 ConvexHull::support(const Vec3 &axis) const
+	{
+		// the center offset is constant for every vertex so compare in quantized space
+		const Vec3 a = axis * m_dequantize;
+		const auto dot = [&](const UInt32 &i)
+		{
+			const QuantizedVertex &q = m_vertices[i];
+			return a.x * q.x + a.y * q.y + a.z * q.z;
+		};
+
+		const UInt32 count = m_vertices.size();
+		if (count <= k_climbThreshold)
+		{
+			UInt32 best = 0;
+			Float bestDot = dot(0);
+			for (UInt32 i = 1; i < count; ++i)
+			{
+				const Float d = dot(i);
+				if (d > bestDot)
+				{
+					bestDot = d;
+					best = i;
+				}
+			}
+			return best;
+		}
+
+		UInt32 best = m_extremes[0];
+		Float bestDot = dot(best);
+		for (UInt32 i = 1; i < 6; ++i)
+		{
+			const Float d = dot(m_extremes[i]);
+			if (d > bestDot)
+			{
+				bestDot = d;
+				best = m_extremes[i];
+			}
+		}
+
+		// a local maximum on a convex hull is the global maximum
+		bool climbing = true;
+		while (climbing)
+		{
+			climbing = false;
+			for (UInt32 i = m_adjacencyOffsets[best], end = m_adjacencyOffsets[best + 1]; i < end; ++i)
+			{
+				const UInt32 neighbor = m_adjacency[i];
+				const Float d = dot(neighbor);
+				if (d > bestDot)
+				{
+					bestDot = d;
+					best = neighbor;
+					climbing = true;
+				}
+			}
+		}
+		return best;
+	}
+
+	bool ConvexHull::raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const
+	{
+		Float tEnter = -FLOAT_MAX;
+		Float tExit = FLOAT_MAX;
+		UInt32 enterPlane = NOT_FOUND;
+
+		// clip the ray against every face plane
+		for (UInt32 i = 0, count = m_planeNormals.size(); i < count; ++i)
+		{
+			const Vec3 &normal = m_planeNormals[i];
+			const Float denom = normal.dot(n);
+			const Float dist = normal.dot(r0) - m_planeDistances[i];
+
+			if (denom == 0)
+			{
+				if (dist > 0)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const Float t = -dist / denom;
+			if (denom < 0)
+			{
+				if (t > tEnter)
+				{
+					tEnter = t;
+					enterPlane = i;
+				}
+			}
+			else if (t < tExit)
+			{
+				tExit = t;
+			}
+
+			if (tEnter > tExit)
+			{
+				return false;
+			}
+		}
+
+		if (enterPlane == NOT_FOUND || tEnter < 0 || (maxDistance > 0 && tEnter > maxDistance))
+		{
+			return false;
+		}
+
+		outPoint = r0 + n * tEnter;
+		outNormal = m_planeNormals[enterPlane];
+		outDistance = tEnter;
+		return true;
+	}
+#pragma endregion // Queries
+}
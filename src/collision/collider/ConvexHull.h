@@ -0,0 +1,92 @@
+/*
+ * Convex hull shape data. Built once from a point cloud and shared between any number of
+ * ConvexHullColliders through the Shape::mesh pointer. The owner must keep it alive for as long
+ * as colliders reference it.
+ */
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+#include "math/Math.h"
+#include "mass/Computer.h"
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+namespace Positional
+{
+	struct ConvexHull final
+	{
+	private:
+		/*
+		 * Vertex quantized to 16 bits per axis relative to the hull bounds
+		 */
+		struct QuantizedVertex
+		{
+			Int16 x, y, z;
+		};
+
+		// hulls with fewer vertices are cheaper to scan than to climb
+		static const UInt32 k_climbThreshold = 16;
+		static const Float k_quantizeScale;
+
+		vector<QuantizedVertex> m_vertices;
+		// vertex adjacency in compressed rows: neighbors of i are m_adjacency[m_adjacencyOffsets[i]..m_adjacencyOffsets[i + 1]]
+		vector<UInt32> m_adjacencyOffsets;
+		vector<UInt32> m_adjacency;
+		vector<UInt32> m_triangles;
+		vector<Vec3> m_planeNormals;
+		vector<Float> m_planeDistances;
+		// starting vertices for hill climbing: extremes along -x, +x, -y, +y, -z, +z
+		UInt32 m_extremes[6];
+		Bounds m_bounds;
+		Vec3 m_dequantize;
+		Mass::Computer m_mass;
+		Float m_volume;
+
+		ConvexHull() : m_volume(0) {}
+
+		void build(const vector<Vec3> &vertices, const vector<UInt32> &triangles);
+
+	public:
+		/*
+		 * Builds the convex hull of the points. Returns null if the points do not span a volume.
+		 */
+		static shared_ptr<ConvexHull> create(const vector<Vec3> &points);
+
+		inline UInt32 vertexCount() const { return m_vertices.size(); }
+		inline UInt32 triangleCount() const { return m_triangles.size() / 3; }
+		inline UInt32 planeCount() const { return m_planeNormals.size(); }
+
+		inline Vec3 vertex(const UInt32 &i) const
+		{
+			const QuantizedVertex &q = m_vertices[i];
+			return m_bounds.center + Vec3(q.x, q.y, q.z) * m_dequantize;
+		}
+
+		inline const UInt32 *triangle(const UInt32 &i) const { return &m_triangles[i * 3]; }
+
+		/*
+		 * Local space bounding box
+		 */
+		inline const Bounds &bounds() const { return m_bounds; }
+
+		inline Float volume() const { return m_volume; }
+
+		/*
+		 * Mass properties at unit density in local space
+		 */
+		inline const Mass::Computer &mass() const { return m_mass; }
+
+		/*
+		 * Returns the index of the farthest vertex along axis
+		 */
+		UInt32 support(const Vec3 &axis) const;
+
+		/*
+		 * Raycast in local space. Rays starting inside the hull do not hit.
+		 */
+		bool raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const;
+	};
+}
+#endif // CONVEX_HULL_H
@@ -0,0 +1,75 @@
+/*
+ * A convex hull collider. The shape mesh points to a ConvexHull which may be shared between colliders.
+ */
+#ifndef CONVEX_HULL_COLLIDER_H
+#define CONVEX_HULL_COLLIDER_H
+
+#include "ShapeId.h"
+#include "mass/Volume.h"
+#include "mass/Computer.h"
+#include "Collider.h"
+#include "ConvexHull.h"
+
+namespace Positional
+{
+	struct ConvexHullCollider final
+	{
+		static UInt8 shapeId() { return ShapeId::Hull; }
+
+		static inline const ConvexHull &hull(const Collider &collider)
+		{
+			assert(collider.shape.mesh != NULL);
+			return *static_cast<const ConvexHull *>(collider.shape.mesh);
+		}
+
+		static Bounds bounds(const Collider &collider)
+		{
+			// tight bounds from the support along each world axis
+			const Vec3 x = collider.vectorToLocal(Vec3::pos_x);
+			const Vec3 y = collider.vectorToLocal(Vec3::pos_y);
+			const Vec3 z = collider.vectorToLocal(Vec3::pos_z);
+
+			Bounds bounds(collider.pointToWorld(localSupport(collider, x)), Vec3::zero);
+			bounds.merge(collider.pointToWorld(localSupport(collider, -x)));
+			bounds.merge(collider.pointToWorld(localSupport(collider, y)));
+			bounds.merge(collider.pointToWorld(localSupport(collider, -y)));
+			bounds.merge(collider.pointToWorld(localSupport(collider, z)));
+			bounds.merge(collider.pointToWorld(localSupport(collider, -z)));
+			return bounds;
+		}
+
+		static Float volume(const Collider &collider) { return hull(collider).volume(); }
+
+		static bool raycast(const Collider &collider, const Ray &ray, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance)
+		{
+			const Vec3 r0 = collider.pointToLocal(ray.origin);
+			const Vec3 n = collider.vectorToLocal(ray.normal());
+			if (hull(collider).raycast(r0, n, maxDistance, outPoint, outNormal, outDistance))
+			{
+				outPoint = collider.pointToWorld(outPoint);
+				outNormal = collider.vectorToWorld(outNormal);
+				return true;
+			}
+			return false;
+		}
+
+		static Vec3 localSupport(const Collider &collider, const Vec3 &axis)
+		{
+			const ConvexHull &h = hull(collider);
+			return h.vertex(h.support(axis));
+		}
+
+		static void computeMass(const Collider &collider, Mass::Computer &computer)
+		{
+			computer = hull(collider).mass();
+			computer.scaleDensity(collider.density);
+			computer.transform(collider.pose.position, collider.pose.rotation);
+		}
+
+		static bool hasRotation() { return true; }
+
+	private:
+		ConvexHullCollider() = delete;
+	};
+}
+#endif // CONVEX_HULL_COLLIDER_H
@@ -0,0 +1,172 @@
+#include "Heightfield.h"
+
+namespace Positional
+{
+	const Float Heightfield::k_quantizeScale = 65535.0;
+
+	/*
+	 * Cell containing a coordinate along one axis, clamped to the grid
+	 */
+	inline UInt32 cellIndex(const Float &x, const Float &cellSize, const UInt32 &cellCount)
+	{
+		return (UInt32)Math::clamp(Math::floor(x / cellSize), 0, cellCount - 1);
+	}
+
+#pragma region Construction
+	shared_ptr<Heightfield> Heightfield::create(const vector<Float> &heights, const UInt32 &columns, const UInt32 &rows, const Float &cellWidth, const Float &cellLength)
+	{
+		if (columns < 2 || rows < 2 || heights.size() != columns * rows || cellWidth <= 0 || cellLength <= 0)
+		{
+			return nullptr;
+		}
+
+		Float minHeight = heights[0];
+		Float maxHeight = heights[0];
+		for (const Float &h : heights)
+		{
+			minHeight = Math::min(minHeight, h);
+			maxHeight = Math::max(maxHeight, h);
+		}
+
+		auto field = shared_ptr<Heightfield>(new Heightfield());
+		field->m_columns = columns;
+		field->m_rows = rows;
+		field->m_cellWidth = cellWidth;
+		field->m_cellLength = cellLength;
+		field->m_minHeight = minHeight;
+		field->m_heightScale = (maxHeight - minHeight) / k_quantizeScale;
+
+		field->m_samples.resize(heights.size());
+		for (UInt32 i = 0, count = heights.size(); i < count; ++i)
+		{
+			field->m_samples[i] = field->m_heightScale > 0
+				? (UInt16)Math::floor((heights[i] - minHeight) / field->m_heightScale + 0.5)
+				: 0;
+		}
+
+		const Vec3 extents((columns - 1) * cellWidth * 0.5, (maxHeight - minHeight) * 0.5, (rows - 1) * cellLength * 0.5);
+		field->m_bounds = Bounds(Vec3(extents.x, minHeight + extents.y, extents.z), extents);
+		return field;
+	}
+#pragma endregion // Construction
+
+#pragma region Queries
+	void Heightfield::intersects(const Bounds &bounds, const TriangleCallback &callback) const
+	{
+		if (!m_bounds.intersects(bounds))
+		{
+			return;
+		}
+
+		const Vec3 min = bounds.min();
+		const Vec3 max = bounds.max();
+		const UInt32 column0 = cellIndex(min.x, m_cellWidth, m_columns - 1);
+		const UInt32 column1 = cellIndex(max.x, m_cellWidth, m_columns - 1);
+		const UInt32 row0 = cellIndex(min.z, m_cellLength, m_rows - 1);
+		const UInt32 row1 = cellIndex(max.z, m_cellLength, m_rows - 1);
+
+		for (UInt32 row = row0; row <= row1; ++row)
+		{
+			for (UInt32 column = column0; column <= column1; ++column)
+			{
+				// reject cells entirely above or below the bounds
+				const UInt16 s00 = m_samples[row * m_columns + column];
+				const UInt16 s10 = m_samples[row * m_columns + column + 1];
+				const UInt16 s01 = m_samples[(row + 1) * m_columns + column];
+				const UInt16 s11 = m_samples[(row + 1) * m_columns + column + 1];
+				const Float low = m_minHeight + Math::min(Math::min(s00, s10), Math::min(s01, s11)) * m_heightScale;
+				const Float high = m_minHeight + Math::max(Math::max(s00, s10), Math::max(s01, s11)) * m_heightScale;
+				if (high < min.y || low > max.y)
+				{
+					continue;
+				}
+
+				const UInt32 cell = row * (m_columns - 1) + column;
+				callback(cell * 2);
+				callback(cell * 2 + 1);
+			}
+		}
+	}
+
+	bool Heightfield::raycastCell(const UInt32 &column, const UInt32 &row, const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const
+	{
+		const UInt32 cell = row * (m_columns - 1) + column;
+		Float nearest = maxDistance;
+		bool hit = false;
+		for (UInt32 i = cell * 2; i <= cell * 2 + 1; ++i)
+		{
+			Vec3 a, b, c, point, normal;
+			Float t;
+			triangle(i, a, b, c);
+			if (GeomUtil::raycastTriangle(a, b, c, r0, n, nearest, point, normal, t))
+			{
+				nearest = t;
+				outPoint = point;
+				outNormal = normal;
+				outDistance = t;
+				hit = true;
+			}
+		}
+		return hit;
+	}
+
+	/*
+	 * 2D DDA over the grid. A triangle only spans its own cell so the first cell with a hit holds the nearest hit.
+	 */
+	bool Heightfield::raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const
+	{
+		Float t;
+		if (!m_bounds.intersects(Ray(r0, n), t))
+		{
+			return false;
+		}
+
+		t = Math::max(t, 0);
+		if (maxDistance > 0 && t > maxDistance)
+		{
+			return false;
+		}
+
+		const Vec3 p = r0 + n * t;
+		Int32 column = cellIndex(p.x, m_cellWidth, m_columns - 1);
+		Int32 row = cellIndex(p.z, m_cellLength, m_rows - 1);
+
+		const Int32 stepColumn = n.x > 0 ? 1 : -1;
+		const Int32 stepRow = n.z > 0 ? 1 : -1;
+		const Float deltaX = n.x != 0 ? m_cellWidth / Math::abs(n.x) : FLOAT_MAX;
+		const Float deltaZ = n.z != 0 ? m_cellLength / Math::abs(n.z) : FLOAT_MAX;
+		Float nextX = n.x != 0 ? ((column + (n.x > 0 ? 1 : 0)) * m_cellWidth - r0.x) / n.x : FLOAT_MAX;
+		Float nextZ = n.z != 0 ? ((row + (n.z > 0 ? 1 : 0)) * m_cellLength - r0.z) / n.z : FLOAT_MAX;
+
+		const Int32 columnCount = m_columns - 1;
+		const Int32 rowCount = m_rows - 1;
+		while (column >= 0 && column < columnCount && row >= 0 && row < rowCount)
+		{
+			if (raycastCell(column, row, r0, n, maxDistance, outPoint, outNormal, outDistance))
+			{
+				return true;
+			}
+
+			if (nextX < nextZ)
+			{
+				t = nextX;
+				nextX += deltaX;
+				column += stepColumn;
+			}
+			else
+			{
+				t = nextZ;
+				nextZ += deltaZ;
+				row += stepRow;
+			}
+
+			if (t == FLOAT_MAX || (maxDistance > 0 && t > maxDistance))
+			{
+				break;
+			}
+		}
+
+		return false;
+	}
+#pragma endregion // Queries
+}
@@ -0,0 +1,96 @@
+/*
+ * Heightfield shape data for terrain. Samples are quantized to 16 bits on a regular grid in the local xz plane
+ * and triangles are generated on demand, the full triangle list is never stored.
+ * Shared between any number of HeightfieldColliders through the Shape::mesh pointer. The owner must keep it alive
+ * for as long as colliders reference it.
+ */
+#ifndef HEIGHTFIELD_H
+#define HEIGHTFIELD_H
+
+#include "math/Math.h"
+#include "TriangleMesh.h"
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+namespace Positional
+{
+	struct Heightfield final
+	{
+	private:
+		static const Float k_quantizeScale;
+
+		vector<UInt16> m_samples;
+		UInt32 m_columns;
+		UInt32 m_rows;
+		Float m_cellWidth;
+		Float m_cellLength;
+		Float m_minHeight;
+		Float m_heightScale;
+		Bounds m_bounds;
+
+		Heightfield() : m_columns(0), m_rows(0), m_cellWidth(0), m_cellLength(0), m_minHeight(0), m_heightScale(0) {}
+
+		inline Float height(const UInt32 &column, const UInt32 &row) const
+		{
+			return m_minHeight + m_samples[row * m_columns + column] * m_heightScale;
+		}
+
+		inline Vec3 vertex(const UInt32 &column, const UInt32 &row) const
+		{
+			return Vec3(column * m_cellWidth, height(column, row), row * m_cellLength);
+		}
+
+		bool raycastCell(const UInt32 &column, const UInt32 &row, const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const;
+
+	public:
+		/*
+		 * Builds a heightfield from row major heights, columns along local x and rows along local z.
+		 * Returns null if there are fewer than 2x2 samples or the sizes do not match.
+		 */
+		static shared_ptr<Heightfield> create(const vector<Float> &heights, const UInt32 &columns, const UInt32 &rows, const Float &cellWidth, const Float &cellLength);
+
+		inline UInt32 columns() const { return m_columns; }
+		inline UInt32 rows() const { return m_rows; }
+		inline UInt32 triangleCount() const { return (m_columns - 1) * (m_rows - 1) * 2; }
+
+		/*
+		 * Each cell is split into two counter-clockwise triangles, index = cell * 2 + half
+		 */
+		inline void triangle(const UInt32 &i, Vec3 &outA, Vec3 &outB, Vec3 &outC) const
+		{
+			const UInt32 cell = i >> 1;
+			const UInt32 column = cell % (m_columns - 1);
+			const UInt32 row = cell / (m_columns - 1);
+			if ((i & 1) == 0)
+			{
+				outA = vertex(column, row);
+				outB = vertex(column, row + 1);
+				outC = vertex(column + 1, row);
+			}
+			else
+			{
+				outA = vertex(column + 1, row);
+				outB = vertex(column, row + 1);
+				outC = vertex(column + 1, row + 1);
+			}
+		}
+
+		/*
+		 * Local space bounding box
+		 */
+		inline const Bounds &bounds() const { return m_bounds; }
+
+		/*
+		 * Calls back with the index of every triangle in the cells overlapping the local space bounds
+		 */
+		void intersects(const Bounds &bounds, const TriangleCallback &callback) const;
+
+		/*
+		 * Nearest front facing hit in local space, walks the cells under the ray in order
+		 */
+		bool raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const;
+	};
+}
+#endif // HEIGHTFIELD_H
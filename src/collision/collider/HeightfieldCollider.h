@@ -0,0 +1,62 @@
+/*
+ * A heightfield collider for static terrain. The shape mesh points to a Heightfield which may be shared
+ * between colliders. Heights are along the local y axis and contacts push shapes out of the top surface.
+ * Only static colliders may use it, World::createCollider rejects it on a body.
+ */
+#ifndef HEIGHTFIELD_COLLIDER_H
+#define HEIGHTFIELD_COLLIDER_H
+
+#include "ShapeId.h"
+#include "mass/Computer.h"
+#include "Collider.h"
+#include "Heightfield.h"
+
+namespace Positional
+{
+	struct HeightfieldCollider final
+	{
+		static UInt8 shapeId() { return ShapeId::Heightfield; }
+
+		static inline const Heightfield &heightfield(const Collider &collider)
+		{
+			assert(collider.shape.mesh != NULL);
+			return *static_cast<const Heightfield *>(collider.shape.mesh);
+		}
+
+		static Bounds bounds(const Collider &collider) { return collider.boundsToWorld(heightfield(collider).bounds()); }
+
+		static Float volume(const Collider &) { return 0; }
+
+		static bool raycast(const Collider &collider, const Ray &ray, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance)
+		{
+			const Vec3 r0 = collider.pointToLocal(ray.origin);
+			const Vec3 n = collider.vectorToLocal(ray.normal());
+			if (heightfield(collider).raycast(r0, n, maxDistance, outPoint, outNormal, outDistance))
+			{
+				outPoint = collider.pointToWorld(outPoint);
+				outNormal = collider.vectorToWorld(outNormal);
+				return true;
+			}
+			return false;
+		}
+
+		/*
+		 * Heightfields are not convex, the narrowphase works on their triangles instead
+		 */
+		static Vec3 localSupport(const Collider &collider, const Vec3 &axis)
+		{
+			const Bounds &local = heightfield(collider).bounds();
+			const Vec3 &e = local.extents();
+			return local.center + Vec3(Math::sign(axis.x) * e.x, Math::sign(axis.y) * e.y, Math::sign(axis.z) * e.z);
+		}
+
+		// static geometry has no mass
+		static void computeMass(const Collider &, Mass::Computer &) {}
+
+		static bool hasRotation() { return true; }
+
+	private:
+		HeightfieldCollider() = delete;
+	};
+}
+#endif // HEIGHTFIELD_COLLIDER_H
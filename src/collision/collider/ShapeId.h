@@ -11,7 +11,12 @@ namespace Positional
 		const UInt8 Sphere = 1 << 1;
 		const UInt8 Capsule = 1 << 2;
 		const UInt8 Cylinder = 1 << 3;
+		const UInt8 Mesh = 1 << 4;
+		const UInt8 Heightfield = 1 << 5;
 		const UInt8 Hull = 1 << 7;
+
+		// static geometry without volume, never attached to a body
+		const UInt8 StaticOnly = Mesh | Heightfield;
 	}
 }
 
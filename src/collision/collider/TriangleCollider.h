@@ -0,0 +1,93 @@
+/*
+ * A single triangle. Not meant to be added to a world: the narrowphase creates these on the stack to run
+ * GJK and EPA against the triangles of meshes. The shape mesh points to three vertices in local space.
+ */
+#ifndef TRIANGLE_COLLIDER_H
+#define TRIANGLE_COLLIDER_H
+
+#include "ShapeId.h"
+#include "mass/Computer.h"
+#include "Collider.h"
+
+namespace Positional
+{
+	struct TriangleCollider final
+	{
+		static UInt8 shapeId() { return ShapeId::Mesh; }
+
+		static inline const Vec3 *vertices(const Collider &collider)
+		{
+			return static_cast<const Vec3 *>(collider.shape.mesh);
+		}
+
+		static Bounds bounds(const Collider &collider)
+		{
+			const Vec3 *v = vertices(collider);
+			Bounds bounds(collider.pointToWorld(v[0]), Vec3::zero);
+			bounds.merge(collider.pointToWorld(v[1]));
+			bounds.merge(collider.pointToWorld(v[2]));
+			return bounds;
+		}
+
+		static Float volume(const Collider &) { return 0; }
+
+		static bool raycast(const Collider &collider, const Ray &ray, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance)
+		{
+			const Vec3 *v = vertices(collider);
+			return GeomUtil::raycastTriangle(
+				collider.pointToWorld(v[0]),
+				collider.pointToWorld(v[1]),
+				collider.pointToWorld(v[2]),
+				ray.origin,
+				ray.normal(),
+				maxDistance,
+				outPoint,
+				outNormal,
+				outDistance);
+		}
+
+		static Vec3 localSupport(const Collider &collider, const Vec3 &axis)
+		{
+			const Vec3 *v = vertices(collider);
+			const Float d0 = axis.dot(v[0]);
+			const Float d1 = axis.dot(v[1]);
+			const Float d2 = axis.dot(v[2]);
+			if (d0 >= d1 && d0 >= d2)
+			{
+				return v[0];
+			}
+			return d1 >= d2 ? v[1] : v[2];
+		}
+
+		static void computeMass(const Collider &, Mass::Computer &) {}
+
+		static bool hasRotation() { return true; }
+
+		/*
+		 * Stack collider for the triangles of a mesh collider, created once per query and pointed at each
+		 * triangle in turn with setVertices
+		 */
+		static inline Collider create(const Collider &mesh)
+		{
+			return Collider::create<TriangleCollider>(
+				mesh.body(),
+				mesh.pose.position,
+				mesh.pose.rotation,
+				Shape((void *)nullptr),
+				0,
+				mesh.staticFriction,
+				mesh.dynamicFriction,
+				mesh.restitution);
+		}
+
+		// the vertices must outlive their use
+		static inline void setVertices(Collider &collider, const Vec3 *vertices)
+		{
+			collider.shape.mesh = (void *)vertices;
+		}
+
+	private:
+		TriangleCollider() = delete;
+	};
+}
+#endif // TRIANGLE_COLLIDER_H
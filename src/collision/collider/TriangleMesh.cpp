@@ -0,0 +1,204 @@
+#include "TriangleMesh.h"
+#include <algorithm>
+
+namespace Positional
+{
+#pragma region Construction
+	shared_ptr<TriangleMesh> TriangleMesh::create(const vector<Vec3> &vertices, const vector<UInt32> &indices)
+	{
+		const UInt32 count = indices.size() / 3;
+		if (count == 0 || indices.size() % 3 != 0)
+		{
+			return nullptr;
+		}
+
+		for (const UInt32 &index : indices)
+		{
+			if (index >= vertices.size())
+			{
+				return nullptr;
+			}
+		}
+
+		auto mesh = shared_ptr<TriangleMesh>(new TriangleMesh());
+		mesh->m_vertices = vertices;
+
+		vector<Vec3> centroids(count);
+		vector<UInt32> order(count);
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			const UInt32 t = i * 3;
+			centroids[i] = (vertices[indices[t]] + vertices[indices[t + 1]] + vertices[indices[t + 2]]) / 3.0;
+			order[i] = i;
+		}
+
+		mesh->m_nodes.reserve(2 * (count / k_leafSize + 1));
+		mesh->build(order, centroids, 0, count);
+
+		// store triangles in leaf order so each leaf is a contiguous range
+		mesh->m_triangles.resize(indices.size());
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			const UInt32 src = order[i] * 3;
+			const UInt32 dst = i * 3;
+			mesh->m_triangles[dst] = indices[src];
+			mesh->m_triangles[dst + 1] = indices[src + 1];
+			mesh->m_triangles[dst + 2] = indices[src + 2];
+		}
+
+		// leaf bounds were built from the centroid order, now fit them to the triangles
+		for (Node &node : mesh->m_nodes)
+		{
+			if (node.isLeaf())
+			{
+				Vec3 a, b, c;
+				mesh->triangle(node.start, a, b, c);
+				node.bounds = Bounds(a, Vec3::zero);
+				for (UInt32 i = node.start, end = node.start + node.count; i < end; ++i)
+				{
+					mesh->triangle(i, a, b, c);
+					node.bounds.merge(a);
+					node.bounds.merge(b);
+					node.bounds.merge(c);
+				}
+			}
+		}
+
+		// refit internal nodes, children always come after their parent
+		for (UInt32 i = mesh->m_nodes.size(); i-- > 0;)
+		{
+			Node &node = mesh->m_nodes[i];
+			if (!node.isLeaf())
+			{
+				node.bounds = mesh->m_nodes[i + 1].bounds.merged(mesh->m_nodes[node.start].bounds);
+			}
+		}
+
+		return mesh;
+	}
+
+	/*
+	 * Top down median split along the longest axis of the centroid bounds
+	 */
+	UInt32 TriangleMesh::build(vector<UInt32> &order, const vector<Vec3> &centroids, const UInt32 &start, const UInt32 &count)
+	{
+		const UInt32 index = m_nodes.size();
+		m_nodes.push_back(Node());
+
+		if (count <= k_leafSize)
+		{
+			m_nodes[index].start = start;
+			m_nodes[index].count = count;
+			return index;
+		}
+
+		Bounds centroidBounds(centroids[order[start]], Vec3::zero);
+		for (UInt32 i = start + 1, end = start + count; i < end; ++i)
+		{
+			centroidBounds.merge(centroids[order[i]]);
+		}
+
+		const Vec3 &e = centroidBounds.extents();
+		const UInt8 axis = e.x >= e.y && e.x >= e.z ? 0 : e.y >= e.z ? 1 : 2;
+		const UInt32 half = count / 2;
+		nth_element(
+			order.begin() + start,
+			order.begin() + start + half,
+			order.begin() + start + count,
+			[&](const UInt32 &lhs, const UInt32 &rhs)
+			{
+				Vec3 l = centroids[lhs], r = centroids[rhs];
+				return l[axis] < r[axis];
+			});
+
+		build(order, centroids, start, half);
+		const UInt32 right = build(order, centroids, start + half, count - half);
+
+		m_nodes[index].start = right;
+		m_nodes[index].count = 0;
+		return index;
+	}
+#pragma endregion // Construction
+
+#pragma region Queries
+	void TriangleMesh::intersects(const Bounds &bounds, const TriangleCallback &callback) const
+	{
+		UInt32 stack[k_stackSize];
+		UInt32 size = 0;
+		stack[size++] = 0;
+
+		while (size > 0)
+		{
+			const UInt32 index = stack[--size];
+			const Node &node = m_nodes[index];
+			if (!node.bounds.intersects(bounds))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (UInt32 i = node.start, end = node.start + node.count; i < end; ++i)
+				{
+					callback(i);
+				}
+			}
+			else
+			{
+				assert(size + 2 <= k_stackSize);
+				stack[size++] = node.start;
+				stack[size++] = index + 1;
+			}
+		}
+	}
+
+	bool TriangleMesh::raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const
+	{
+		const Ray ray(r0, n);
+		Float nearest = maxDistance;
+		bool hit = false;
+
+		UInt32 stack[k_stackSize];
+		UInt32 size = 0;
+		stack[size++] = 0;
+
+		while (size > 0)
+		{
+			const UInt32 index = stack[--size];
+			const Node &node = m_nodes[index];
+
+			Float distance;
+			if (!node.bounds.intersects(ray, distance) || (nearest > 0 && distance > nearest))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (UInt32 i = node.start, end = node.start + node.count; i < end; ++i)
+				{
+					Vec3 a, b, c, point, normal;
+					Float t;
+					triangle(i, a, b, c);
+					if (GeomUtil::raycastTriangle(a, b, c, r0, n, nearest, point, normal, t))
+					{
+						nearest = t;
+						outPoint = point;
+						outNormal = normal;
+						outDistance = t;
+						hit = true;
+					}
+				}
+			}
+			else
+			{
+				assert(size + 2 <= k_stackSize);
+				stack[size++] = node.start;
+				stack[size++] = index + 1;
+			}
+		}
+
+		return hit;
+	}
+#pragma endregion // Queries
+}
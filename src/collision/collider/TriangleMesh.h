@@ -0,0 +1,83 @@
+/*
+ * Triangle mesh shape data with a compact bounding volume hierarchy for the mid-phase.
+ * Built once and shared between any number of TriangleMeshColliders through the Shape::mesh pointer.
+ * The owner must keep it alive for as long as colliders reference it.
+ */
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+#include "math/Math.h"
+#include <vector>
+#include <memory>
+#include <functional>
+
+using namespace std;
+
+namespace Positional
+{
+	typedef function<void(const UInt32 &)> TriangleCallback;
+
+	struct TriangleMesh final
+	{
+	private:
+		/*
+		 * Nodes are stored depth first, so the left child of an internal node always follows it.
+		 * Leaves reference a contiguous range of m_triangles.
+		 */
+		struct Node
+		{
+			Bounds bounds;
+			// leaf: first triangle, internal: index of the right child
+			UInt32 start;
+			// triangle count, zero for internal nodes
+			UInt32 count;
+
+			inline bool isLeaf() const { return count > 0; }
+		};
+
+		static const UInt32 k_leafSize = 4;
+		static const UInt32 k_stackSize = 64;
+
+		vector<Vec3> m_vertices;
+		vector<UInt32> m_triangles;
+		vector<Node> m_nodes;
+
+		TriangleMesh() {}
+
+		UInt32 build(vector<UInt32> &order, const vector<Vec3> &centroids, const UInt32 &start, const UInt32 &count);
+
+	public:
+		/*
+		 * Builds a mesh from vertices and counter-clockwise triangle indices. Returns null if the indices are invalid.
+		 */
+		static shared_ptr<TriangleMesh> create(const vector<Vec3> &vertices, const vector<UInt32> &indices);
+
+		inline UInt32 vertexCount() const { return m_vertices.size(); }
+		inline UInt32 triangleCount() const { return m_triangles.size() / 3; }
+		inline UInt32 nodeCount() const { return m_nodes.size(); }
+
+		inline void triangle(const UInt32 &i, Vec3 &outA, Vec3 &outB, Vec3 &outC) const
+		{
+			const UInt32 t = i * 3;
+			outA = m_vertices[m_triangles[t]];
+			outB = m_vertices[m_triangles[t + 1]];
+			outC = m_vertices[m_triangles[t + 2]];
+		}
+
+		/*
+		 * Local space bounding box
+		 */
+		inline const Bounds &bounds() const { return m_nodes[0].bounds; }
+
+		/*
+		 * Calls back with the index of every triangle whose bounds intersect the local space bounds
+		 */
+		void intersects(const Bounds &bounds, const TriangleCallback &callback) const;
+
+		/*
+		 * Nearest front facing hit in local space
+		 */
+		bool raycast(const Vec3 &r0, const Vec3 &n, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance) const;
+	};
+}
+#endif // TRIANGLE_MESH_H
@@ -0,0 +1,62 @@
+/*
+ * A triangle mesh collider for static geometry. The shape mesh points to a TriangleMesh which may be shared
+ * between colliders. Triangles are one sided, contacts push shapes out along the counter-clockwise normal.
+ * Only static colliders may use it, World::createCollider rejects it on a body.
+ */
+#ifndef TRIANGLE_MESH_COLLIDER_H
+#define TRIANGLE_MESH_COLLIDER_H
+
+#include "ShapeId.h"
+#include "mass/Computer.h"
+#include "Collider.h"
+#include "TriangleMesh.h"
+
+namespace Positional
+{
+	struct TriangleMeshCollider final
+	{
+		static UInt8 shapeId() { return ShapeId::Mesh; }
+
+		static inline const TriangleMesh &mesh(const Collider &collider)
+		{
+			assert(collider.shape.mesh != NULL);
+			return *static_cast<const TriangleMesh *>(collider.shape.mesh);
+		}
+
+		static Bounds bounds(const Collider &collider) { return collider.boundsToWorld(mesh(collider).bounds()); }
+
+		static Float volume(const Collider &) { return 0; }
+
+		static bool raycast(const Collider &collider, const Ray &ray, const Float &maxDistance, Vec3 &outPoint, Vec3 &outNormal, Float &outDistance)
+		{
+			const Vec3 r0 = collider.pointToLocal(ray.origin);
+			const Vec3 n = collider.vectorToLocal(ray.normal());
+			if (mesh(collider).raycast(r0, n, maxDistance, outPoint, outNormal, outDistance))
+			{
+				outPoint = collider.pointToWorld(outPoint);
+				outNormal = collider.vectorToWorld(outNormal);
+				return true;
+			}
+			return false;
+		}
+
+		/*
+		 * Meshes are not convex, the narrowphase works on their triangles instead
+		 */
+		static Vec3 localSupport(const Collider &collider, const Vec3 &axis)
+		{
+			const Bounds &local = mesh(collider).bounds();
+			const Vec3 &e = local.extents();
+			return local.center + Vec3(Math::sign(axis.x) * e.x, Math::sign(axis.y) * e.y, Math::sign(axis.z) * e.z);
+		}
+
+		// static geometry has no mass
+		static void computeMass(const Collider &, Mass::Computer &) {}
+
+		static bool hasRotation() { return true; }
+
+	private:
+		TriangleMeshCollider() = delete;
+	};
+}
+#endif // TRIANGLE_MESH_COLLIDER_H
@@ -6,6 +6,20 @@ namespace Positional::Collision
 	bool GJKEPANarrowphase::compute(const Collider &a, const Collider &b, ContactPoint &outContact) const
 	{
 		const UInt8 shapePair = a.shapeId() | b.shapeId();
+		if ((shapePair & ShapeId::Mesh) == ShapeId::Mesh)
+		{
+			return a.shapeId() == ShapeId::Mesh
+					? Penetration::meshConvex(a, b, false, outContact)
+					: Penetration::meshConvex(b, a, true, outContact);
+		}
+
+		if ((shapePair & ShapeId::Heightfield) == ShapeId::Heightfield)
+		{
+			return a.shapeId() == ShapeId::Heightfield
+					? Penetration::heightfieldConvex(a, b, false, outContact)
+					: Penetration::heightfieldConvex(b, a, true, outContact);
+		}
+
 		switch (shapePair)
 		{
 		case ShapeId::Sphere:
@@ -45,9 +59,43 @@ namespace Positional::Collision
 		return Penetration::sphereCapsule(b, a, true, outContact);
 	}
 
+	bool meshConvexNoSwap(const Collider &a, const Collider &b, ContactPoint &outContact)
+	{
+		return Penetration::meshConvex(a, b, false, outContact);
+	}
+
+	bool meshConvexSwap(const Collider &a, const Collider &b, ContactPoint &outContact)
+	{
+		return Penetration::meshConvex(b, a, true, outContact);
+	}
+
+	bool heightfieldConvexNoSwap(const Collider &a, const Collider &b, ContactPoint &outContact)
+	{
+		return Penetration::heightfieldConvex(a, b, false, outContact);
+	}
+
+	bool heightfieldConvexSwap(const Collider &a, const Collider &b, ContactPoint &outContact)
+	{
+		return Penetration::heightfieldConvex(b, a, true, outContact);
+	}
+
 	PenetrationFunction GJKEPANarrowphase::getComputeFunction(const Collider &a, const Collider &b) const
 	{
 		const UInt8 shapePair = a.shapeId() | b.shapeId();
+		if ((shapePair & ShapeId::Mesh) == ShapeId::Mesh)
+		{
+			return a.shapeId() == ShapeId::Mesh
+					? meshConvexNoSwap
+					: meshConvexSwap;
+		}
+
+		if ((shapePair & ShapeId::Heightfield) == ShapeId::Heightfield)
+		{
+			return a.shapeId() == ShapeId::Heightfield
+					? heightfieldConvexNoSwap
+					: heightfieldConvexSwap;
+		}
+
 		switch (shapePair)
 		{
 		case ShapeId::Sphere:
@@ -12,7 +12,7 @@ using namespace std;
 
 namespace Positional::Collision
 {
-	typedef function<bool(const Collider &, const Collider &, ContactPoint &)> PenetrationFunction;
+	typedef bool (*PenetrationFunction)(const Collider &, const Collider &, ContactPoint &);
 
 	class INarrowphase
 	{
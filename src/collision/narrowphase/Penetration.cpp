@@ -4,6 +4,9 @@
 #include "collision/collider/BoxCollider.h"
 #include "collision/collider/SphereCollider.h"
 #include "collision/collider/CapsuleCollider.h"
+#include "collision/collider/TriangleCollider.h"
+#include "collision/collider/TriangleMeshCollider.h"
+#include "collision/collider/HeightfieldCollider.h"
 #include "Simplex.h"
 #include "Polytope.h"
 
@@ -23,8 +26,8 @@ namespace Positional::Collision
 	{
 		outContact.normal = normal;
 		outContact.depth = depth;
-		outContact.pointA = Body::pointToLocal(a.body(), center + normal * (radius - depth));
-		outContact.pointB = Body::pointToLocal(b.body(), center + normal * radius);
+		outContact.pointA = a.worldToBody(center + normal * (radius - depth));
+		outContact.pointB = b.worldToBody(center + normal * radius);
 	}
 
 	inline void makeContact(
@@ -169,6 +172,138 @@ namespace Positional::Collision
 		return false;
 	}
 
+	const UInt32 k_maxTriangleContacts = 8;
+	// contacts with normals within this cosine of the deepest contact are merged into its normal
+	const Float k_triangleMergeCos = 0.9;
+
+	/*
+	 * Gathers contacts against individual triangles and reduces them to a single contact
+	 */
+	struct TriangleContacts
+	{
+		ContactPoint contacts[k_maxTriangleContacts];
+		UInt32 count;
+
+		TriangleContacts() : count(0) {}
+
+		void add(const ContactPoint &contact)
+		{
+			if (count < k_maxTriangleContacts)
+			{
+				contacts[count++] = contact;
+				return;
+			}
+
+			// full: replace the shallowest contact
+			UInt32 shallowest = 0;
+			for (UInt32 i = 1; i < count; ++i)
+			{
+				if (contacts[i].depth < contacts[shallowest].depth)
+				{
+					shallowest = i;
+				}
+			}
+
+			if (contact.depth > contacts[shallowest].depth)
+			{
+				contacts[shallowest] = contact;
+			}
+		}
+
+		bool reduce(const bool &swapped, ContactPoint &outContact) const
+		{
+			if (count == 0)
+			{
+				return false;
+			}
+
+			UInt32 deepest = 0;
+			for (UInt32 i = 1; i < count; ++i)
+			{
+				if (contacts[i].depth > contacts[deepest].depth)
+				{
+					deepest = i;
+				}
+			}
+
+			// depth weighted normal of neighbouring faces to smooth out internal edges
+			const Vec3 &n = contacts[deepest].normal;
+			Vec3 normal = Vec3::zero;
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				if (contacts[i].normal.dot(n) >= k_triangleMergeCos)
+				{
+					normal += contacts[i].normal * contacts[i].depth;
+				}
+			}
+
+			outContact = contacts[deepest];
+			if (normal.lengthSq() > 0)
+			{
+				outContact.normal = normal.normalize();
+			}
+
+			if (swapped)
+			{
+				outContact.normal = -outContact.normal;
+				std::swap(outContact.pointA, outContact.pointB);
+			}
+			return true;
+		}
+	};
+
+	/*
+	 * Triangle vertices and convex center are in the local space of the mesh
+	 */
+	inline void triangleConvex(const Collider &mesh, Collider &triangleCollider, const Collider &convex, const Vec3 *triangle, const Vec3 &center, TriangleContacts &ioContacts)
+	{
+		// one sided: ignore shapes whose center is behind the face
+		const Vec3 faceNormal = GeomUtil::normal(triangle[0], triangle[1], triangle[2]);
+		if (faceNormal.dot(center - triangle[0]) < 0)
+		{
+			return;
+		}
+
+		ContactPoint contact;
+		TriangleCollider::setVertices(triangleCollider, triangle);
+		if (Penetration::gjk_epa(triangleCollider, convex, contact) && contact.normal.dot(mesh.vectorToWorld(faceNormal)) < 0)
+		{
+			ioContacts.add(contact);
+		}
+	}
+
+	/*
+	 * Collides a convex shape against the triangles of static geometry overlapping its bounds.
+	 * TrianglesT provides intersects(bounds, callback) and triangle(i, a, b, c) in the local space of the collider.
+	 */
+	template <typename TrianglesT>
+	inline bool trianglesConvex(const Collider &collider, const TrianglesT &triangles, const Collider &convex, const bool &swapped, ContactPoint &outContact)
+	{
+		const Bounds bounds = collider.boundsToLocal(convex.bounds());
+		const Vec3 center = collider.pointToLocal(convex.pointToWorld(Vec3::zero));
+
+		TriangleContacts contacts;
+		Collider triangleCollider = TriangleCollider::create(collider);
+		triangles.intersects(bounds, [&](const UInt32 &i)
+		{
+			Vec3 triangle[3];
+			triangles.triangle(i, triangle[0], triangle[1], triangle[2]);
+			triangleConvex(collider, triangleCollider, convex, triangle, center, contacts);
+		});
+
+		return contacts.reduce(swapped, outContact);
+	}
+
+	bool Penetration::meshConvex(const Collider &mesh, const Collider &convex, const bool &swapped, ContactPoint &outContact)
+	{
+		return trianglesConvex(mesh, TriangleMeshCollider::mesh(mesh), convex, swapped, outContact);
+	}
+
+	bool Penetration::heightfieldConvex(const Collider &heightfield, const Collider &convex, const bool &swapped, ContactPoint &outContact)
+	{
+		return trianglesConvex(heightfield, HeightfieldCollider::heightfield(heightfield), convex, swapped, outContact);
+	}
+
 	inline UInt8 leastSignificantComponent(const Vec3 &v)
 	{
 		if (v.x <= v.y && v.x <= v.z)
@@ -345,19 +480,21 @@ namespace Positional::Collision
 			vb.p,
 			vc.p);
 
-		outContact.pointA = Body::pointToLocal(a.body(), a.pointToWorld(
+		outContact.pointA = a.localToBody(
 			va.a * bary.x
 			+ vb.a * bary.y
-			+ vc.a * bary.z));
+			+ vc.a * bary.z);
 
-		outContact.pointB = Body::pointToLocal(b.body(), b.pointToWorld(
+		outContact.pointB = b.localToBody(
 			va.b * bary.x
 			+ vb.b * bary.y
-			+ vc.b * bary.z));
+			+ vc.b * bary.z);
 
 
 		outContact.depth = Math::sqrt(nearestLenSq);
-		outContact.normal = nearest / -outContact.depth;
-		
+		// touching shapes put the origin on the face, take the direction from the face itself
+		outContact.normal = outContact.depth > 0
+			? nearest / -outContact.depth
+			: -ioPolytope.normals[nearestTriIdx].normalized();
 	}
 } // namespace Positional
@@ -21,6 +21,8 @@ namespace Positional::Collision
 		static bool capsuleCapsule(const Collider &a, const Collider &b, ContactPoint &outContact);
 		static bool boxSphere(const Collider &box, const Collider &sphere, const bool &swapped, ContactPoint &outContact);
 		static bool sphereCapsule(const Collider &sphere, const Collider &capsule, const bool &swapped, ContactPoint &outContact);
+		static bool meshConvex(const Collider &mesh, const Collider &convex, const bool &swapped, ContactPoint &outContact);
+		static bool heightfieldConvex(const Collider &heightfield, const Collider &convex, const bool &swapped, ContactPoint &outContact);
 
 		static bool gjk_epa(const Collider &a, const Collider &b, ContactPoint &outContact);
 		static bool gjk(const Collider &a, const Collider &b, GJK_EPA_CSO &outSimplex);
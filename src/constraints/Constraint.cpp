@@ -32,8 +32,8 @@ namespace Positional
 		const optional<Vec3>& posA,
 		const optional<Vec3>& posB) const
 	{
-		const Float w0 = bodyA.valid() ? bodyA.get().getInverseMass(correctionNormal, posA) : 0.0;
-		const Float w1 = bodyB.valid() ? bodyB.get().getInverseMass(correctionNormal, posB) : 0.0;
+		const Float w0 = resolvedA->getInverseMass(correctionNormal, posA);
+		const Float w1 = resolvedB->getInverseMass(correctionNormal, posB);
 		const Float w = w0 + w1;
 
 		if (w == 0.0)
@@ -4,51 +4,43 @@
 #include "math/Math.h"
 #include "simulation/Body.h"
 #include "data/Store.h"
+#include "data/IdPair.h"
 
 using namespace std;
 namespace Positional
 {
-	struct Constraint final
-	{
-	private:
-		void (*m_applyForces)(Constraint &, const Float &);
-		void (*m_solvePositions)(Constraint &, const Float &);
-		void (*m_solveVelocities)(Constraint &, const Float &, const Float &);
+	template <class DataT>
+	struct TypedConstraint;
 
-	public:
+	/*
+	 * Bodies and correction helpers shared by every constraint type, the data lives next to it in a TypedConstraint
+	 */
+	struct Constraint
+	{
 		Ref<Body> bodyA;
 		Ref<Body> bodyB;
-		shared_ptr<void> data;
 		bool ignoreCollisions;
 
-		void applyForces(const Float &dtInvSq)
-		{
-			m_applyForces(*this, dtInvSq);
-		}
+		// body keys registered with the world when ignoring collisions, kept so they outlive the bodies
+		IdPair<UInt64> ignoreKey;
 
-		void solvePositions(const Float &dtInvSq)
-		{
-			m_solvePositions(*this, dtInvSq);
-		}
+		// resolved by the world at the start of every step, Body::immovable when static
+		Body *resolvedA;
+		Body *resolvedB;
+
+		Constraint() : ignoreCollisions(false), ignoreKey(0, 0), resolvedA(&Body::immovable), resolvedB(&Body::immovable) {}
 
-		void solveVelocities(const Float &dt, const Float &dtInvSq)
+		inline void resolve(Store<Body> &bodies)
 		{
-			m_solveVelocities(*this, dt, dtInvSq);
+			resolvedA = bodyA.valid() ? &bodies[bodyA.index()] : &Body::immovable;
+			resolvedB = bodyB.valid() ? &bodies[bodyB.index()] : &Body::immovable;
 		}
 
 		template<class T>
-		T *getData() const { return static_cast<T*>(data.get());}
+		T *getData() { return &static_cast<TypedConstraint<T> *>(this)->data; }
 
-		template <class ConstraintT, class DataT>
-		static Constraint create()
-		{
-			Constraint constraint;
-			constraint.m_applyForces = ConstraintT::applyForces;
-			constraint.m_solvePositions = ConstraintT::solvePositions;
-			constraint.m_solveVelocities = ConstraintT::solveVelocities;
-			constraint.data = make_shared<DataT>();
-			return constraint;
-		}
+		template<class T>
+		const T *getData() const { return &static_cast<const TypedConstraint<T> *>(this)->data; }
 
 		template <class DataT, typename... DataArgs>
 		void init(const Ref<Body> &first, const Ref<Body> &second, const bool &_ignoreCollisions, DataArgs &&...dataArgs)
@@ -115,16 +107,18 @@ namespace Positional
 			const optional<Vec3> &posB = std::nullopt)
 		{
 			const Vec3 correction = normal * lambda;
-			if (bodyA.valid())
-			{
-				bodyA.get().applyCorrection(-correction, posA, velLevel);
-			}
-
-			if (bodyB.valid())
-			{
-				bodyB.get().applyCorrection(correction, posB, velLevel);
-			}
+			resolvedA->applyCorrection(-correction, posA, velLevel);
+			resolvedB->applyCorrection(correction, posB, velLevel);
 		}
 	};
+
+	/*
+	 * Constraint stored by value together with its data, one contiguous pool per data type
+	 */
+	template <class DataT>
+	struct TypedConstraint final : public Constraint
+	{
+		DataT data;
+	};
 }
 #endif // CONSTRAINT_H
\ No newline at end of file
@@ -0,0 +1,122 @@
+/*
+ * Contiguous storage of one constraint type. The solver calls into a pool once per run of
+ * constraints and the pool loops over them with the type's functions bound at compile time.
+ */
+#ifndef CONSTRAINT_POOL_H
+#define CONSTRAINT_POOL_H
+
+#include "math/Math.h"
+#include "Constraint.h"
+#include "data/Store.h"
+#include <functional>
+#include <atomic>
+
+using namespace std;
+
+namespace Positional
+{
+	/*
+	 * Dense id per constraint data type, in order of first use
+	 */
+	struct ConstraintTypes final
+	{
+		template <class DataT>
+		static UInt32 id()
+		{
+			static const UInt32 s_id = next();
+			return s_id;
+		}
+
+	private:
+		static UInt32 next()
+		{
+			// types may be first used from several threads at once
+			static atomic<UInt32> s_next(0);
+			return s_next.fetch_add(1);
+		}
+
+		ConstraintTypes() = delete;
+	};
+
+	class IConstraintPool
+	{
+	public:
+		virtual ~IConstraintPool() {};
+
+		virtual UInt32 count() const = 0;
+		virtual Constraint &constraint(const UInt32 &index) = 0;
+
+		/*
+		 * Store indices in the order the constraints were created
+		 */
+		virtual void forEachOrdered(const function<void(const UInt32 &index)> &callback) const = 0;
+		virtual void erase(const function<bool(const Constraint &constraint)> &predicate) = 0;
+
+		virtual void applyForces(const UInt32 *indices, const UInt32 &count, const Float &dt) = 0;
+		virtual void solvePositions(const UInt32 *indices, const UInt32 &count, const Float &dtInvSq) = 0;
+		virtual void solveVelocities(const UInt32 *indices, const UInt32 &count, const Float &dt, const Float &dtInvSq) = 0;
+	};
+
+	/*
+	 * Storage part, enough to hand out and erase handles without knowing the solver functions
+	 */
+	template <class DataT>
+	class TypedConstraintPool : public IConstraintPool
+	{
+	protected:
+		Store<TypedConstraint<DataT>> m_store;
+
+	public:
+		inline Ref<TypedConstraint<DataT>> store(const TypedConstraint<DataT> &constraint) { return m_store.store(constraint); }
+		inline bool erase(const Ref<TypedConstraint<DataT>> &ref) { return m_store.erase(ref); }
+
+		virtual UInt32 count() const override { return m_store.count(); }
+		virtual Constraint &constraint(const UInt32 &index) override { return m_store[index]; }
+
+		virtual void forEachOrdered(const function<void(const UInt32 &index)> &callback) const override
+		{
+			m_store.forEachOrdered([&](const Ref<TypedConstraint<DataT>> &ref)
+			{
+				callback(ref.index());
+			});
+		}
+
+		virtual void erase(const function<bool(const Constraint &constraint)> &predicate) override
+		{
+			m_store.erase([&](const Ref<TypedConstraint<DataT>> &ref)
+			{
+				return predicate(ref.get());
+			});
+		}
+	};
+
+	template <class ConstraintT, class DataT>
+	class ConstraintPool final : public TypedConstraintPool<DataT>
+	{
+	public:
+		virtual void applyForces(const UInt32 *indices, const UInt32 &count, const Float &dt) override
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				ConstraintT::applyForces(this->m_store[indices[i]], dt);
+			}
+		}
+
+		virtual void solvePositions(const UInt32 *indices, const UInt32 &count, const Float &dtInvSq) override
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				ConstraintT::solvePositions(this->m_store[indices[i]], dtInvSq);
+			}
+		}
+
+		virtual void solveVelocities(const UInt32 *indices, const UInt32 &count, const Float &dt, const Float &dtInvSq) override
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				ConstraintT::solveVelocities(this->m_store[indices[i]], dt, dtInvSq);
+			}
+		}
+	};
+}
+#endif // CONSTRAINT_POOL_H
@@ -1,135 +1,191 @@
 #include "ContactConstraint.h"
 
 #include "collision/narrowphase/Penetration.h"
-#include "simulation/World.h"
 
 namespace Positional
 {
-	inline void getContacts(const Constraint &constraint, const ContactConstraint::Data *data, Vec3 &posA, Vec3 &posB)
+	inline void getContacts(const Body *a, const Body *b, const ContactConstraint::Data &data, Vec3 &posA, Vec3 &posB)
 	{
-		posA = Body::pointToWorld(constraint.bodyA, data->contact.pointA);
-		posB = Body::pointToWorld(constraint.bodyB, data->contact.pointB);
+		posA = a->pose.transform(data.contact.pointA);
+		posB = b->pose.transform(data.contact.pointB);
 	}
 
-	inline void getPreContacts(const Constraint &constraint, const ContactConstraint::Data *data, Vec3 &posA, Vec3 &posB)
+	inline void getPreContacts(const Body *a, const Body *b, const ContactConstraint::Data &data, Vec3 &posA, Vec3 &posB)
 	{
-		posA = Body::prePointToWorld(constraint.bodyA, data->contact.pointA);
-		posB = Body::prePointToWorld(constraint.bodyB, data->contact.pointB);
+		posA = a->prePose.transform(data.contact.pointA);
+		posB = b->prePose.transform(data.contact.pointB);
 	}
 
+	inline Vec3 getVelocity(const Body *a, const Body *b, const Vec3 &posA, const Vec3 &posB)
+	{
+		return a->getVelocityAt(posA) - b->getVelocityAt(posB);
+	}
 
-	inline void getCOMs(const Constraint &constraint, Vec3 &preA, Vec3 &comA, Vec3 &preB, Vec3 &comB)
+	inline Vec3 getPreVelocity(const Body *a, const Body *b, const Vec3 &posA, const Vec3 &posB)
 	{
-		preA = Body::preCOM(constraint.bodyA);
-		comA = Body::COM(constraint.bodyA);
-		preB = Body::preCOM(constraint.bodyB);
-		comB = Body::COM(constraint.bodyB);
+		return a->getPreVelocityAt(posA) - b->getPreVelocityAt(posB);
 	}
 
-	inline Vec3 getVelocity(const Constraint& constraint, Vec3& posA, const Vec3& posB)
+	/*
+	 * Contacts are rigid, so these are Constraint::computeCorrections and applyCorrections without compliance
+	 */
+	inline bool computeLambda(Body *a, Body *b, const Vec3 &normal, const Float &length, const Vec3 &posA, const Vec3 &posB, Float &outLambda)
 	{
-		Vec3 velocity(0);
-		if (constraint.bodyA.valid())
+		const Float w = a->getInverseMass(normal, posA) + b->getInverseMass(normal, posB);
+
+		if (w == 0.0)
 		{
-			const Body &a = constraint.bodyA.get();
-			velocity = a.getVelocityAt( posA);
+			return false;
 		}
 
-		if (constraint.bodyB.valid())
+		outLambda = -length / w;
+		return true;
+	}
+
+	inline bool computeCorrectionLambda(Body *a, Body *b, const Vec3 &correction, const Vec3 &posA, const Vec3 &posB, Vec3 &outNormal, Float &outLambda)
+	{
+		const Float cSq = correction.lengthSq();
+		if (cSq <= 0)
 		{
-			const Body &b = constraint.bodyB.get();
-			velocity = velocity - b.getVelocityAt(posB);
+			return false;
 		}
 
-		return velocity;
+		outNormal = correction.normalized();
+		return computeLambda(a, b, outNormal, Math::sqrt(cSq), posA, posB, outLambda);
 	}
 
-	inline Vec3 getPreVelocity(const Constraint &constraint, const Vec3 &posA, const Vec3 &posB)
+	inline void applyCorrections(Body *a, Body *b, const Vec3 &normal, const Float &lambda, const bool &velLevel, const Vec3 &posA, const Vec3 &posB)
 	{
-		Vec3 velocity(0);
-		if (constraint.bodyA.valid())
+		const Vec3 correction = normal * lambda;
+		a->applyCorrection(-correction, posA, velLevel);
+		b->applyCorrection(correction, posB, velLevel);
+	}
+
+	inline void applyCorrections(Body *a, Body *b, const Vec3 &correction, const bool &velLevel, const Vec3 &posA, const Vec3 &posB)
+	{
+		Vec3 n;
+		Float lambda;
+		if (computeCorrectionLambda(a, b, correction, posA, posB, n, lambda))
 		{
-			const Body &a = constraint.bodyA.get();
-			velocity = a.getPreVelocityAt(posA);
+			applyCorrections(a, b, n, lambda, velLevel, posA, posB);
 		}
+	}
 
-		if (constraint.bodyB.valid())
+	/*
+	 * Sweeps the center of mass from its pre pose against the other collider and pulls the body back
+	 * to one ccd radius before the hit
+	 */
+	inline void sweep(Body *body, const Collider &other)
+	{
+		// kinematic bodies go where they are told
+		if (!body->ccd || body->isKinematic())
 		{
-			const Body &b = constraint.bodyB.get();
-			velocity = velocity - b.getPreVelocityAt(posB);
+			return;
 		}
 
-		return velocity;
+		const Vec3 from = body->prePose.transform(body->massPose.position);
+		const Vec3 motion = body->pose.transform(body->massPose.position) - from;
+		const Float distance = motion.length();
+		const Float radius = body->ccdRadius();
+
+		// slow enough for the discrete contact to catch
+		if (distance <= radius)
+		{
+			return;
+		}
+
+		const Vec3 n = motion / distance;
+		Vec3 point, normal;
+		Float t;
+		if (other.raycast(Ray(from, n), distance, point, normal, t))
+		{
+			body->pose.position -= n * (distance - Math::max(t - radius, 0));
+			body->poseChanged();
+		}
+	}
+
+	void ContactConstraint::solveContinuous(Data &data, const Context &context)
+	{
+		sweep(context.body(data.bodyA), context.collider(data.colliderB));
+		sweep(context.body(data.bodyB), context.collider(data.colliderA));
 	}
 
-	void ContactConstraint::solvePositions(Constraint &constraint, const Float &dtInvSq)
+	bool ContactConstraint::isContinuous(const Data &data, const Context &context)
 	{
-		auto data = constraint.getData<Data>();
-		data->update();
-		if (!data->colliding)
+		return context.body(data.bodyA)->ccd || context.body(data.bodyB)->ccd;
+	}
+
+	void ContactConstraint::solvePositions(Data &data, const Context &context, const Float &dtInvSq)
+	{
+		update(data, context);
+		if (!data.colliding)
 		{
 			return;
 		}
 
+		Body *a = context.body(data.bodyA);
+		Body *b = context.body(data.bodyB);
+
 		Vec3 posA, posB;
-		getContacts(constraint, data, posA, posB);
+		getContacts(a, b, data, posA, posB);
 		// penetration
 		Float lambdaN;
-		if (constraint.computeCorrections(data->contact.normal, data->contact.depth, 0, dtInvSq, lambdaN, posA, posB))
+		if (computeLambda(a, b, data.contact.normal, data.contact.depth, posA, posB, lambdaN))
 		{
-			data->contact.force = Math::abs(lambdaN * dtInvSq);
+			data.contact.force = Math::abs(lambdaN * dtInvSq);
 			// apply penetration correction
-			constraint.applyCorrections(data->contact.normal, lambdaN, false, posA, posB);
+			applyCorrections(a, b, data.contact.normal, lambdaN, false, posA, posB);
 
 			// static friction
 			Vec3 preA, preB;
-			getContacts(constraint, data, posA, posB);
-			getPreContacts(constraint, data, preA, preB);
+			getContacts(a, b, data, posA, posB);
+			getPreContacts(a, b, data, preA, preB);
 
 			const Vec3 dp = (posB - preB) - (posA - preA);
-			const Vec3 dpTan = dp - data->contact.normal * dp.dot(data->contact.normal);
+			const Vec3 dpTan = dp - data.contact.normal * dp.dot(data.contact.normal);
 			Vec3 normalT;
 			Float lambdaT;
-			if (constraint.computeCorrections(dpTan, 0, dtInvSq, normalT, lambdaT, posA, posB) &&
-				Math::abs(lambdaT) > Math::abs(data->staticFriction * lambdaN))
+			if (computeCorrectionLambda(a, b, dpTan, posA, posB, normalT, lambdaT) &&
+				Math::abs(lambdaT) > Math::abs(data.staticFriction * lambdaN))
 			{
-				constraint.applyCorrections(normalT, lambdaT, false, posA, posB);
+				applyCorrections(a, b, normalT, lambdaT, false, posA, posB);
 			}
 		}
 	}
 
-	void ContactConstraint::solveVelocities(Constraint &constraint, const Float &dt, const Float &dtInvSq)
+	void ContactConstraint::solveVelocities(Data &data, const Context &context, const Float &dt)
 	{
-		auto data = constraint.getData<Data>();
-		if (data->colliding)
+		if (data.colliding)
 		{
-			optional<World *> world = constraint.getWorld();
-			assert(world.has_value());
+			Body *a = context.body(data.bodyA);
+			Body *b = context.body(data.bodyB);
 
 			Vec3 v, preA, posA, preB, posB;
 			Float vn;
-			getPreContacts(constraint, data, preA, preB);
-			getContacts(constraint, data, posA, posB);
+			getPreContacts(a, b, data, preA, preB);
+			getContacts(a, b, data, posA, posB);
 
-			v = getVelocity(constraint, posA, posB);
-			vn = data->contact.normal.dot(v);
+			v = getVelocity(a, b, posA, posB);
+			vn = data.contact.normal.dot(v);
 
-			// dynamic friction
-			const Vec3 vt = v - data->contact.normal * vn;
+			// dynamic friction, nothing to do without tangential velocity
+			const Vec3 vt = v - data.contact.normal * vn;
 			const Float vtLen = vt.length();
-			const Vec3 dynamicFriction = vt * -(Math::min(dt * data->dynamicFriction * data->contact.force, vtLen) / vtLen);
-
-			constraint.applyCorrections(dynamicFriction, 0, dtInvSq, true, posA, posB);
+			if (vtLen > 0)
+			{
+				const Vec3 dynamicFriction = vt * -(Math::min(dt * data.dynamicFriction * data.contact.force, vtLen) / vtLen);
+				applyCorrections(a, b, dynamicFriction, true, posA, posB);
+			}
 
 			// restitution
-			v = getVelocity(constraint, posA, posB);
-			vn = data->contact.normal.dot(v);
-			const Vec3 preVel = getPreVelocity(constraint, preA, preB);
-
-			const Float preVn = data->contact.normal.dot(preVel);
-			const Float e = Math::abs(vn) < 2.0 * dt * world.value()->gravity.length() ? 0 : data->restitution;
-			const Vec3 restitution = data->contact.normal * (-vn + Math::max(-e * preVn, 0));
-			constraint.applyCorrections(restitution, 0, dtInvSq, true, posA, posB);
+			v = getVelocity(a, b, posA, posB);
+			vn = data.contact.normal.dot(v);
+			const Vec3 preVel = getPreVelocity(a, b, preA, preB);
+
+			const Float preVn = data.contact.normal.dot(preVel);
+			const Float e = Math::abs(vn) < 2.0 * dt * context.gravity.length() ? 0 : data.restitution;
+			const Vec3 restitution = data.contact.normal * (-vn + Math::max(-e * preVn, 0));
+			applyCorrections(a, b, restitution, true, posA, posB);
 		}
 	}
-}
\ No newline at end of file
+}
@@ -2,24 +2,28 @@
 #define CONTACT_CONSTRAINT_H
 
 #include "math/Math.h"
-#include "Constraint.h"
+#include "simulation/Body.h"
 #include "collision/narrowphase/INarrowphase.h"
-#include <functional>
 
 using namespace std;
 namespace Positional
 {
+	/*
+	 * Contacts live in a plain array reused across steps, they refer to bodies and colliders by store index
+	 */
 	struct ContactConstraint final
 	{
 		struct Data final
 		{
-		private:
-			Collision::PenetrationFunction m_compute;
+			Collision::PenetrationFunction compute;
+			// pair the contact was created from, for reporting
+			UInt32 pair;
+			// store indices resolved when the pair is collected, bodies are NOT_FOUND when static
+			UInt32 bodyA;
+			UInt32 bodyB;
+			UInt32 colliderA;
+			UInt32 colliderB;
 
-		public:
-			Ref<Collider> colliderA;
-			Ref<Collider> colliderB;
-			
 			bool colliding;
 			Float staticFriction;
 			Float dynamicFriction;
@@ -27,33 +31,61 @@ namespace Positional
 			ContactPoint contact;
 
 			Data() = default;
-			inline void init(const Ref<Collider> &_colliderA, const Ref<Collider> &_colliderB, const Collision::INarrowphase *narrowphase)
+			inline void init(const UInt32 &_pair, const Ref<Collider> &_colliderA, const Ref<Collider> &_colliderB, const Collision::INarrowphase *narrowphase)
 			{
 				const Collider &collA = _colliderA.get();
 				const Collider &collB = _colliderB.get();
 
-				m_compute = narrowphase->getComputeFunction(collA, collB);
+				compute = narrowphase->getComputeFunction(collA, collB);
 
-				colliderA = _colliderA;
-				colliderB = _colliderB;
+				pair = _pair;
+				bodyA = collA.body().valid() ? collA.body().index() : NOT_FOUND;
+				bodyB = collB.body().valid() ? collB.body().index() : NOT_FOUND;
+				colliderA = _colliderA.index();
+				colliderB = _colliderB.index();
 				colliding = false;
 				staticFriction = (collA.staticFriction + collB.staticFriction) * 0.5;
 				dynamicFriction = (collA.dynamicFriction + collB.dynamicFriction) * 0.5;
 				restitution = (collA.restitution + collB.restitution) * 0.5;
 			}
+		};
 
-			inline void update()
-			{
-				colliding = m_compute(colliderA.get(), colliderB.get(), contact);
-			}
+		/*
+		 * Stores the contact indices point into, valid for one step
+		 */
+		struct Context final
+		{
+			Store<Body> *bodies;
+			Store<Collider> *colliders;
+			Vec3 gravity;
+
+			inline Body *body(const UInt32 &index) const { return index != NOT_FOUND ? &(*bodies)[index] : &Body::immovable; }
+			inline const Collider &collider(const UInt32 &index) const { return (*colliders)[index]; }
 		};
 
-		static void applyForces(Constraint &constraint, const Float &dtInvSq) {}
-		static void solvePositions(Constraint &constraint, const Float &dtInvSq);
-		static void solveVelocities(Constraint &constraint, const Float &dt, const Float &dtInvSq);
+		/*
+		 * Runs the narrowphase at the current poses
+		 */
+		static inline void update(Data &data, const Context &context)
+		{
+			data.colliding = data.compute(context.collider(data.colliderA), context.collider(data.colliderB), data.contact);
+		}
+
+		static void solvePositions(Data &data, const Context &context, const Float &dtInvSq);
+		static void solveVelocities(Data &data, const Context &context, const Float &dt);
+
+		/*
+		 * Clamps the motion of continuous bodies to the time of impact with the other collider
+		 */
+		static void solveContinuous(Data &data, const Context &context);
+
+		/*
+		 * Does either body of the contact use continuous collision detection
+		 */
+		static bool isContinuous(const Data &data, const Context &context);
 
 	private:
 		ContactConstraint() = delete;
 	};
 }
-#endif // CONTACT_CONSTRAINT_H
\ No newline at end of file
+#endif // CONTACT_CONSTRAINT_H
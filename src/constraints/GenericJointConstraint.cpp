@@ -4,34 +4,14 @@ namespace Positional
 {
 	inline void getPositions(const Constraint &constraint, const GenericJointConstraint::Data *data, Vec3 &outPosA, Vec3 &outPosB)
 	{
-		outPosA = data->poseA.position;
-
-		if (constraint.bodyA.valid())
-		{
-			outPosA = constraint.bodyA.get().pose.transform(outPosA);
-		}
-
-		outPosB = data->poseB.position;
-		if (constraint.bodyB.valid())
-		{
-			outPosB = constraint.bodyB.get().pose.transform(outPosB);
-		}
+		outPosA = constraint.resolvedA->pose.transform(data->poseA.position);
+		outPosB = constraint.resolvedB->pose.transform(data->poseB.position);
 	}
 
 	inline void getRotations(const Constraint &constraint, const GenericJointConstraint::Data *data, Quat &outRotA, Quat &outRotB)
 	{
-		outRotA = data->poseA.rotation;
-
-		if (constraint.bodyA.valid())
-		{
-			outRotA = constraint.bodyA.get().pose.rotation * outRotA;
-		}
-
-		outRotB = data->poseB.rotation;
-		if (constraint.bodyB.valid())
-		{
-			outRotB = constraint.bodyB.get().pose.rotation * outRotB;
-		}
+		outRotA = constraint.resolvedA->pose.rotation * data->poseA.rotation;
+		outRotB = constraint.resolvedB->pose.rotation * data->poseB.rotation;
 	}
 
 	inline void applyAngleLimits(Constraint &constraint, const Vec3 &normal, const Float &compliance, const Vec3 &a, const Vec3 &b, const Float &min, const Float &max, const Float &dtInvSq, const Float maxCorr = Math::Pi)
@@ -186,11 +166,7 @@ namespace Positional
 			{
 				getPositions(constraint, d, posA, posB);
 
-				Quat rotB = d->poseB.rotation;
-				if (constraint.bodyB.valid())
-				{
-					rotB = constraint.bodyB.get().pose.rotation * rotB;
-				}
+				const Quat rotB = constraint.resolvedB->pose.rotation * d->poseB.rotation;
 
 				const Vec3 n = rotB * Vec3::pos_x;
 				const Vec3 corr = (posB - posA).project(n);
@@ -205,11 +181,7 @@ namespace Positional
 			{
 				getPositions(constraint, d, posA, posB);
 
-				Quat rotB = d->poseB.rotation;
-				if (constraint.bodyB.valid())
-				{
-					rotB = constraint.bodyB.get().pose.rotation * rotB;
-				}
+				const Quat rotB = constraint.resolvedB->pose.rotation * d->poseB.rotation;
 
 				const Vec3 n = rotB * Vec3::pos_x;
 
@@ -227,11 +199,7 @@ namespace Positional
 			{
 				getPositions(constraint, d, posA, posB);
 
-				Quat rotB = d->poseB.rotation;
-				if (constraint.bodyB.valid())
-				{
-					rotB = constraint.bodyB.get().pose.rotation * rotB;
-				}
+				const Quat rotB = constraint.resolvedB->pose.rotation * d->poseB.rotation;
 
 				const Vec3 n = rotB * Vec3::pos_x;
 
@@ -265,11 +233,7 @@ namespace Positional
 			Vec3 posA, posB;
 			getPositions(constraint, d, posA, posB);
 
-			Quat rotB = d->poseB.rotation;
-			if (constraint.bodyB.valid())
-			{
-				rotB = constraint.bodyB.get().pose.rotation * rotB;
-			}
+			const Quat rotB = constraint.resolvedB->pose.rotation * d->poseB.rotation;
 
 			const Vec3 n = rotB * Vec3::pos_x;
 			Vec3 corr = (posB - posA).projectOnPlane(n);
@@ -297,16 +261,7 @@ namespace Positional
 
 		if (d->rotationDamping > 0)
 		{
-			Vec3 omega(0);
-			if (constraint.bodyB.valid())
-			{
-				omega = constraint.bodyB.get().velocity.angular;
-			}
-
-			if (constraint.bodyA.valid())
-			{
-				omega = omega - constraint.bodyA.get().velocity.angular;
-			}
+			Vec3 omega = constraint.resolvedB->velocity.angular - constraint.resolvedA->velocity.angular;
 
 			omega = omega * Math::min(d->rotationDamping * dt, 1.0);
 			constraint.applyCorrections(omega, 0, dtInvSq, true);
@@ -314,21 +269,12 @@ namespace Positional
 
 		if (d->positionDamping > 0)
 		{
-			Vec3 posA = 0, posB = 0, vel = 0;
+			Vec3 posA = 0;
+			const Vec3 posB = constraint.resolvedB->pose.transform(d->poseB.position);
+			Vec3 vel = constraint.resolvedB->getVelocityAt(posA);
 
-			if (constraint.bodyB.valid())
-			{
-				const Body &body = constraint.bodyB.get();
-				posB = body.pose.transform(d->poseB.position);
-				vel = body.getVelocityAt(posA);
-			}
-
-			if (constraint.bodyA.valid())
-			{
-				const Body &body = constraint.bodyA.get();
-				posA = body.pose.transform(d->poseA.position);
-				vel = vel - body.getVelocityAt(posA);
-			}
+			posA = constraint.resolvedA->pose.transform(d->poseA.position);
+			vel = vel - constraint.resolvedA->getVelocityAt(posA);
 
 			vel = vel * Math::min(d->positionDamping * dt, 1);
 			constraint.applyCorrections(vel, 0, dtInvSq, true, posA, posB);
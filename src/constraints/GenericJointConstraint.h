@@ -54,6 +54,7 @@ namespace Positional
 				hasLimits = _hasLimit;
 				positionCompliance = _positionCompliance;
 				positionDamping = _positionDamping;
+				rotationCompliance = _rotationCompliance;
 				rotationDamping = _rotationDamping;
 				linearLimit = _linearLimit;
 				minTwist = _minTwist;
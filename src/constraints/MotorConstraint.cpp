@@ -8,22 +8,18 @@ namespace Positional
 
 		if (Math::abs(data->torque) > Math::Epsilon)
 		{
-			Quat rot = data->rotation;
-			if (constraint.bodyA.valid())
-			{
-				rot = constraint.bodyA.get().pose.rotation * rot;
-			}
-
+			const Quat rot = constraint.resolvedA->pose.rotation * data->rotation;
 			const Vec3 torque = rot * Vec3(data->torque, 0, 0);
 
-			if (constraint.bodyA.valid())
+			// the immovable body is shared and kinematic bodies ignore forces, motors sharing either run side by side
+			if (constraint.resolvedA != &Body::immovable && !constraint.resolvedA->isKinematic())
 			{
-				constraint.bodyA.get().forces.angular += torque;
+				constraint.resolvedA->forces.angular += torque;
 			}
 
-			if (constraint.bodyB.valid())
+			if (constraint.resolvedB != &Body::immovable && !constraint.resolvedB->isKinematic())
 			{
-				constraint.bodyB.get().forces.angular -= torque;
+				constraint.resolvedB->forces.angular -= torque;
 			}
 		}
 	}
@@ -0,0 +1,270 @@
+#include "WideContactSolver.h"
+
+namespace Positional
+{
+	/*
+	 * One side of every contact in a batch, static and padding lanes hold Body::immovable
+	 */
+	struct BodyLanes
+	{
+		alignas(Wide::alignment) Float px[Wide::width];
+		alignas(Wide::alignment) Float py[Wide::width];
+		alignas(Wide::alignment) Float pz[Wide::width];
+		alignas(Wide::alignment) Float qx[Wide::width];
+		alignas(Wide::alignment) Float qy[Wide::width];
+		alignas(Wide::alignment) Float qz[Wide::width];
+		alignas(Wide::alignment) Float qw[Wide::width];
+		alignas(Wide::alignment) Float mpx[Wide::width];
+		alignas(Wide::alignment) Float mpy[Wide::width];
+		alignas(Wide::alignment) Float mpz[Wide::width];
+		alignas(Wide::alignment) Float mqx[Wide::width];
+		alignas(Wide::alignment) Float mqy[Wide::width];
+		alignas(Wide::alignment) Float mqz[Wide::width];
+		alignas(Wide::alignment) Float mqw[Wide::width];
+		alignas(Wide::alignment) Float invMass[Wide::width];
+		alignas(Wide::alignment) Float ix[Wide::width];
+		alignas(Wide::alignment) Float iy[Wide::width];
+		alignas(Wide::alignment) Float iz[Wide::width];
+		// contact point in body space and at the pre pose in world space
+		alignas(Wide::alignment) Float cx[Wide::width];
+		alignas(Wide::alignment) Float cy[Wide::width];
+		alignas(Wide::alignment) Float cz[Wide::width];
+		alignas(Wide::alignment) Float prx[Wide::width];
+		alignas(Wide::alignment) Float pry[Wide::width];
+		alignas(Wide::alignment) Float prz[Wide::width];
+		// written back after the solve, null when the body does not move
+		Body *body[Wide::width];
+
+		inline void gather(const UInt32 &lane, Body *b, const Vec3 &point)
+		{
+			// sleeping and kinematic bodies keep their pose so contact points match the scalar solver
+			const bool dynamic = !b->isSleeping() && !b->isKinematic();
+			body[lane] = dynamic ? b : nullptr;
+
+			const Pose &pose = b->pose;
+			const Pose &massPose = b->massPose;
+			const Vec3 pre = b->prePose.transform(point);
+			const Vec3 inertia = dynamic ? b->invInertia : Vec3::zero;
+
+			px[lane] = pose.position.x; py[lane] = pose.position.y; pz[lane] = pose.position.z;
+			qx[lane] = pose.rotation.x; qy[lane] = pose.rotation.y; qz[lane] = pose.rotation.z; qw[lane] = pose.rotation.w;
+			mpx[lane] = massPose.position.x; mpy[lane] = massPose.position.y; mpz[lane] = massPose.position.z;
+			mqx[lane] = massPose.rotation.x; mqy[lane] = massPose.rotation.y; mqz[lane] = massPose.rotation.z; mqw[lane] = massPose.rotation.w;
+			invMass[lane] = dynamic ? b->invMass : 0;
+			ix[lane] = inertia.x; iy[lane] = inertia.y; iz[lane] = inertia.z;
+			cx[lane] = point.x; cy[lane] = point.y; cz[lane] = point.z;
+			prx[lane] = pre.x; pry[lane] = pre.y; prz[lane] = pre.z;
+		}
+	};
+
+	/*
+	 * Pose and mass of one side in lanes, the same steps as Body::getInverseMass and Body::applyCorrection
+	 */
+	struct WideBody
+	{
+		WideVec3 position;
+		WideQuat rotation;
+		WideVec3 massPosition;
+		WideQuat massRotation;
+		Wide invMass;
+		WideVec3 invInertia;
+		WideVec3 point;
+		WideVec3 prePoint;
+
+		WideBody(const BodyLanes &l) :
+			position(Wide::load(l.px), Wide::load(l.py), Wide::load(l.pz)),
+			rotation(Wide::load(l.qx), Wide::load(l.qy), Wide::load(l.qz), Wide::load(l.qw)),
+			massPosition(Wide::load(l.mpx), Wide::load(l.mpy), Wide::load(l.mpz)),
+			massRotation(Wide::load(l.mqx), Wide::load(l.mqy), Wide::load(l.mqz), Wide::load(l.mqw)),
+			invMass(Wide::load(l.invMass)),
+			invInertia(Wide::load(l.ix), Wide::load(l.iy), Wide::load(l.iz)),
+			point(Wide::load(l.cx), Wide::load(l.cy), Wide::load(l.cz)),
+			prePoint(Wide::load(l.prx), Wide::load(l.pry), Wide::load(l.prz)) {}
+
+		inline WideVec3 com() const { return position + rotation.rotate(massPosition); }
+		inline WideVec3 pointToWorld() const { return position + rotation.rotate(point); }
+
+		inline Wide inverseMass(const WideVec3 &normal, const WideVec3 &pos) const
+		{
+			const WideVec3 n = (rotation * massRotation).inverseRotate((pos - com()).cross(normal));
+			return invMass + (n * n).dot(invInertia);
+		}
+
+		inline void applyCorrection(const WideVec3 &correction, const WideVec3 &pos, const Wide &mask)
+		{
+			const WideVec3 movedPosition = position + correction * invMass;
+			const WideVec3 worldCOM = movedPosition + rotation.rotate(massPosition);
+
+			const WideQuat inertiaRotation = rotation * massRotation;
+			const WideVec3 dq = inertiaRotation.rotate(inertiaRotation.inverseRotate((pos - worldCOM).cross(correction)) * invInertia);
+
+			// clamp max rotations per substep
+			const Wide maxPhi(0.5);
+			const Wide phi = Wide::sqrt(dq.lengthSq());
+			const Wide clamp = phi > maxPhi;
+			const Wide qh = Wide::select(clamp, maxPhi / Wide::select(clamp, phi, Wide(1.0)), Wide(1.0));
+
+			const Wide half(0.5);
+			const WideQuat delta = WideQuat(dq.x * qh, dq.y * qh, dq.z * qh, Wide(0.0)) * rotation;
+			const WideQuat rotated = WideQuat(
+				rotation.x + half * delta.x,
+				rotation.y + half * delta.y,
+				rotation.z + half * delta.z,
+				rotation.w + half * delta.w).normalized();
+
+			// maintain center of mass position in world space
+			position = WideVec3::select(mask, worldCOM - rotated.rotate(massPosition), position);
+			rotation = WideQuat::select(mask, rotated, rotation);
+		}
+
+		inline void scatter(const BodyLanes &l, const UInt32 &lanes, const UInt32 &mask) const
+		{
+			alignas(Wide::alignment) Float out[7][Wide::width];
+			position.x.store(out[0]); position.y.store(out[1]); position.z.store(out[2]);
+			rotation.x.store(out[3]); rotation.y.store(out[4]); rotation.z.store(out[5]); rotation.w.store(out[6]);
+
+			for (UInt32 i = 0; i < lanes; ++i)
+			{
+				if (l.body[i] != nullptr && (mask & (1u << i)) != 0)
+				{
+					l.body[i]->pose.position = Vec3(out[0][i], out[1][i], out[2][i]);
+					l.body[i]->pose.rotation = Quat(out[3][i], out[4][i], out[5][i], out[6][i]);
+					l.body[i]->poseChanged();
+				}
+			}
+		}
+	};
+
+	struct ContactLanes
+	{
+		alignas(Wide::alignment) Float nx[Wide::width];
+		alignas(Wide::alignment) Float ny[Wide::width];
+		alignas(Wide::alignment) Float nz[Wide::width];
+		alignas(Wide::alignment) Float depth[Wide::width];
+		alignas(Wide::alignment) Float staticFriction[Wide::width];
+		ContactConstraint::Data *contact[Wide::width];
+		BodyLanes a;
+		BodyLanes b;
+
+		inline void gather(const UInt32 &lane, ContactConstraint::Data &data, Body *bodyA, Body *bodyB)
+		{
+			contact[lane] = &data;
+			nx[lane] = data.contact.normal.x; ny[lane] = data.contact.normal.y; nz[lane] = data.contact.normal.z;
+			depth[lane] = data.contact.depth;
+			staticFriction[lane] = data.staticFriction;
+			a.gather(lane, bodyA, data.contact.pointA);
+			b.gather(lane, bodyB, data.contact.pointB);
+		}
+
+		// unused lanes solve to nothing, zero depth and zero mass never pass the checks
+		inline void pad(const UInt32 &lane)
+		{
+			contact[lane] = nullptr;
+			nx[lane] = ny[lane] = nz[lane] = depth[lane] = staticFriction[lane] = 0;
+			a.gather(lane, &Body::immovable, Vec3::zero);
+			b.gather(lane, &Body::immovable, Vec3::zero);
+		}
+	};
+
+	/*
+	 * Penetration and static friction of ContactConstraint::solvePositions for all lanes
+	 */
+	inline void solveLanes(ContactLanes &lanes, const UInt32 &count, const Float &dtInvSq)
+	{
+		for (UInt32 i = count; i < Wide::width; ++i)
+		{
+			lanes.pad(i);
+		}
+
+		const Wide zero(0.0);
+		const Wide one(1.0);
+		const WideVec3 normal(Wide::load(lanes.nx), Wide::load(lanes.ny), Wide::load(lanes.nz));
+		WideBody a(lanes.a);
+		WideBody b(lanes.b);
+
+		// penetration
+		WideVec3 posA = a.pointToWorld();
+		WideVec3 posB = b.pointToWorld();
+		const Wide w = a.inverseMass(normal, posA) + b.inverseMass(normal, posB);
+		const Wide solved = w > zero;
+		const Wide lambdaN = Wide::select(solved, -Wide::load(lanes.depth) / Wide::select(solved, w, one), zero);
+
+		const WideVec3 correction = normal * lambdaN;
+		a.applyCorrection(-correction, posA, solved);
+		b.applyCorrection(correction, posB, solved);
+
+		// static friction
+		posA = a.pointToWorld();
+		posB = b.pointToWorld();
+		const WideVec3 dp = (posB - b.prePoint) - (posA - a.prePoint);
+		const WideVec3 dpTan = dp - normal * dp.dot(normal);
+		const Wide cSq = dpTan.lengthSq();
+		const Wide sliding = solved & (cSq > zero);
+		const Wide length = Wide::sqrt(cSq);
+		const WideVec3 normalT = dpTan * (one / Wide::select(sliding, length, one));
+
+		const Wide wT = a.inverseMass(normalT, posA) + b.inverseMass(normalT, posB);
+		const Wide hasT = sliding & (wT > zero);
+		const Wide lambdaT = -length / Wide::select(hasT, wT, one);
+		const Wide applied = hasT & (Wide::abs(lambdaT) > Wide::abs(Wide::load(lanes.staticFriction) * lambdaN));
+
+		const WideVec3 correctionT = normalT * Wide::select(applied, lambdaT, zero);
+		a.applyCorrection(-correctionT, posA, applied);
+		b.applyCorrection(correctionT, posB, applied);
+
+		alignas(Wide::alignment) Float force[Wide::width];
+		Wide::abs(lambdaN * Wide(dtInvSq)).store(force);
+		const UInt32 solvedBits = Wide::bits(solved);
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			if ((solvedBits & (1u << i)) != 0)
+			{
+				lanes.contact[i]->contact.force = force[i];
+			}
+		}
+
+		a.scatter(lanes.a, count, solvedBits);
+		b.scatter(lanes.b, count, solvedBits);
+	}
+
+	// particles keep a linear pose, the lanes assume rotating bodies
+	inline bool hasLanes(const Body *body)
+	{
+		return body->pose.usesRotation && body->massPose.usesRotation;
+	}
+
+	void WideContactSolver::solvePositions(ContactConstraint::Data *contacts, const UInt32 *indices, const UInt32 &count, const ContactConstraint::Context &context, const Float &dtInvSq)
+	{
+		ContactLanes lanes;
+		UInt32 used = 0;
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			ContactConstraint::Data &data = contacts[indices[i]];
+			Body *a = context.body(data.bodyA);
+			Body *b = context.body(data.bodyB);
+			if (!hasLanes(a) || !hasLanes(b))
+			{
+				ContactConstraint::solvePositions(data, context, dtInvSq);
+				continue;
+			}
+
+			ContactConstraint::update(data, context);
+			if (!data.colliding)
+			{
+				continue;
+			}
+
+			lanes.gather(used++, data, a, b);
+			if (used == Wide::width)
+			{
+				solveLanes(lanes, used, dtInvSq);
+				used = 0;
+			}
+		}
+
+		if (used > 0)
+		{
+			solveLanes(lanes, used, dtInvSq);
+		}
+	}
+}
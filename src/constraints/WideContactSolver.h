@@ -0,0 +1,28 @@
+#ifndef WIDE_CONTACT_SOLVER_H
+#define WIDE_CONTACT_SOLVER_H
+
+#include "math/Math.h"
+#include "math/Wide.h"
+#include "ContactConstraint.h"
+
+using namespace std;
+namespace Positional
+{
+	/*
+	 * Position solve of ContactConstraint for Wide::width contacts at a time. Body state is gathered into
+	 * lanes, inverse masses, lambdas and corrections are computed for all lanes together and the poses are
+	 * written back. The narrowphase still runs per contact.
+	 */
+	struct WideContactSolver final
+	{
+		/*
+		 * Solves contacts[indices[0..count)], which must not share a dynamic body, as within one solver color.
+		 * Matches ContactConstraint::solvePositions up to rounding.
+		 */
+		static void solvePositions(ContactConstraint::Data *contacts, const UInt32 *indices, const UInt32 &count, const ContactConstraint::Context &context, const Float &dtInvSq);
+
+	private:
+		WideContactSolver() = delete;
+	};
+}
+#endif // WIDE_CONTACT_SOLVER_H
@@ -0,0 +1,47 @@
+/*
+ * Allocator for vectors read and written with aligned SIMD loads and stores
+ */
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+using namespace std;
+
+namespace Positional
+{
+	template <class T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		typedef T value_type;
+
+		template <class U>
+		struct rebind
+		{
+			typedef AlignedAllocator<U, Alignment> other;
+		};
+
+		AlignedAllocator() noexcept {}
+
+		template <class U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+		T *allocate(const size_t count)
+		{
+			return static_cast<T *>(::operator new(count * sizeof(T), align_val_t(Alignment)));
+		}
+
+		void deallocate(T *pointer, const size_t) noexcept
+		{
+			::operator delete(pointer, align_val_t(Alignment));
+		}
+
+		template <class U>
+		bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept { return true; }
+
+		template <class U>
+		bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept { return false; }
+	};
+}
+#endif // ALIGNED_ALLOCATOR_H
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 
@@ -125,6 +126,26 @@ namespace Positional
 			}
 		}
 		
+		/*
+		 * Visits elements in the order they were stored, independent of the hash map layout
+		 */
+		void forEachOrdered(const function<void(const Ref<T> &elRef)> &callback) const
+		{
+			vector<UInt64> keys;
+			keys.reserve(m_handles.size());
+			for (const auto &[key, handle] : m_handles)
+			{
+				keys.push_back(key);
+			}
+			std::sort(keys.begin(), keys.end());
+
+			for (const auto &key : keys)
+			{
+				Ref<T> ref(m_handles.at(key));
+				callback(ref);
+			}
+		}
+
 		void first(const function<bool(const Ref<T> &elRef)> &predicate)
 		{
 			for (const auto &[key, handle] : m_handles)
@@ -192,6 +213,17 @@ namespace Positional
 			return shPtr->id;
 		}
 
+		/*
+		 * Current position in the store, changes when other elements are erased
+		 */
+		inline UInt64 index() const
+		{
+			assert(!m_ptr.expired);
+			auto shPtr = m_ptr.lock();
+			assert(shPtr->store != NULL);
+			return shPtr->index;
+		}
+
 		inline T &get() const
 		{
 			assert(!m_ptr.expired);
@@ -31,6 +31,19 @@ namespace Positional::Mass
 			return quat;
 		}
 
+		inline static void subexpressions(const Float &w0, const Float &w1, const Float &w2, Float &f1, Float &f2, Float &f3, Float &g0, Float &g1, Float &g2)
+		{
+			const Float temp0 = w0 + w1;
+			const Float temp1 = w0 * w0;
+			const Float temp2 = temp1 + w1 * temp0;
+			f1 = temp0 + w2;
+			f2 = temp2 + w2 * f1;
+			f3 = w0 * temp1 + w1 * temp2 + w2 * f2;
+			g0 = f2 + w0 * (f1 + w0);
+			g1 = f2 + w1 * (f1 + w1);
+			g2 = f2 + w2 * (f1 + w2);
+		}
+
 		inline static UInt8 getNextIndex3(UInt8 i)
 		{
 			return (i + 1ui8 + (i >> 1ui8)) & 3ui8;
@@ -306,6 +319,67 @@ namespace Positional::Mass
 			rotate(rotation);
 			translate(translation);
 		}
+
+		/*
+		 * Closed triangle mesh with counter-clockwise (outward) winding.
+		 * Volume integration from David Eberly's "Polyhedral Mass Properties (Revisited)".
+		 */
+		void setPolyhedron(const Vec3 *vertices, const UInt32 *triangles, const UInt32 &triangleCount, const Float &density)
+		{
+			// integrals of 1, x, y, z, x^2, y^2, z^2, xy, yz, zx
+			Float intg[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+			for (UInt32 i = 0, count = triangleCount * 3; i < count; i += 3)
+			{
+				const Vec3 &v0 = vertices[triangles[i]];
+				const Vec3 &v1 = vertices[triangles[i + 1]];
+				const Vec3 &v2 = vertices[triangles[i + 2]];
+				const Vec3 d = (v1 - v0).cross(v2 - v0);
+
+				Float f1x, f2x, f3x, g0x, g1x, g2x;
+				Float f1y, f2y, f3y, g0y, g1y, g2y;
+				Float f1z, f2z, f3z, g0z, g1z, g2z;
+				subexpressions(v0.x, v1.x, v2.x, f1x, f2x, f3x, g0x, g1x, g2x);
+				subexpressions(v0.y, v1.y, v2.y, f1y, f2y, f3y, g0y, g1y, g2y);
+				subexpressions(v0.z, v1.z, v2.z, f1z, f2z, f3z, g0z, g1z, g2z);
+
+				intg[0] += d.x * f1x;
+				intg[1] += d.x * f2x;
+				intg[2] += d.y * f2y;
+				intg[3] += d.z * f2z;
+				intg[4] += d.x * f3x;
+				intg[5] += d.y * f3y;
+				intg[6] += d.z * f3z;
+				intg[7] += d.x * (v0.y * g0x + v1.y * g1x + v2.y * g2x);
+				intg[8] += d.y * (v0.z * g0y + v1.z * g1y + v2.z * g2y);
+				intg[9] += d.z * (v0.x * g0z + v1.x * g1z + v2.x * g2z);
+			}
+
+			const Float m = intg[0] * (1.0 / 6.0) * density;
+			assert(m > 0);
+
+			const Float s2 = density / 24.0;
+			const Float s3 = density / 60.0;
+			const Float s4 = density / 120.0;
+			const Vec3 com = Vec3(intg[1], intg[2], intg[3]) * (s2 / m);
+			const Float xx = intg[4] * s3, yy = intg[5] * s3, zz = intg[6] * s3;
+			const Float xy = intg[7] * s4, yz = intg[8] * s4, zx = intg[9] * s4;
+
+			// inertia relative to the center of mass, then shifted back to the origin
+			m_inertia.set(
+				yy + zz - m * (com.y * com.y + com.z * com.z), -(xy - m * com.x * com.y), -(zx - m * com.z * com.x),
+				-(xy - m * com.x * com.y), zz + xx - m * (com.z * com.z + com.x * com.x), -(yz - m * com.y * com.z),
+				-(zx - m * com.z * com.x), -(yz - m * com.y * com.z), xx + yy - m * (com.x * com.x + com.y * com.y));
+			m_mass = m;
+			m_com = Vec3::zero;
+			translate(com);
+		}
+
+		void setPolyhedron(const Vec3 *vertices, const UInt32 *triangles, const UInt32 &triangleCount, const Vec3 &translation, const Quat &rotation, const Float &density)
+		{
+			setPolyhedron(vertices, triangles, triangleCount, density);
+			rotate(rotation);
+			translate(translation);
+		}
 	};
 }
 
@@ -24,6 +24,22 @@ namespace Positional::Volume
 	{
 		return Math::Pi * radius * radius * length;
 	}
+
+	/*
+	 * Volume of a closed triangle mesh with counter-clockwise (outward) winding
+	 */
+	inline static Float polyhedron(const Vec3 *vertices, const UInt32 *triangles, const UInt32 &triangleCount)
+	{
+		Float volume = 0;
+		for (UInt32 i = 0, count = triangleCount * 3; i < count; i += 3)
+		{
+			const Vec3 &a = vertices[triangles[i]];
+			const Vec3 &b = vertices[triangles[i + 1]];
+			const Vec3 &c = vertices[triangles[i + 2]];
+			volume += a.dot(b.cross(c));
+		}
+		return volume / 6.0;
+	}
 }
 
 #endif // VOLUME_H
\ No newline at end of file
@@ -351,32 +351,27 @@ namespace Positional
 		const Vec3 n = u.cross(v);
 
 		const Float nrn = n.dot(rn);
-		if (nrn < 0)
+		if (nrn >= 0)
 		{
 			// ray is parallel or in same direction as normal
 			return false;
 		}
 
-		const Float t = (n.dot(r0) + n.dot(a)) / nrn;
+		const Float t = n.dot(a - r0) / nrn;
 		if (t >= 0 && (maxDist <= 0 || t < maxDist))
 		{
 			const Vec3 p = r0 + rn * t;
-			const Vec3 uxp = u.cross(p);
-			const Vec3 pxv = p.cross(v);
+			const Vec3 w = p - a;
 
-			// calculate signed areas squared (area of the parellelagram formed by two vectors)
+			// signed areas relative to the triangle area (area of the parellelagram formed by two vectors)
 			const Float area = n.lengthSq();
-			const Float areaU = uxp.lengthSq() * Math::sign(uxp.dot(n));
-			const Float areaV = pxv.lengthSq() * Math::sign(pxv.dot(n));
+			const Float S = u.cross(w).dot(n) / area;
+			const Float T = w.cross(v).dot(n) / area;
 
-			// squared barycentric coords
-			const Float S = areaU / area;
-			const Float T = areaV / area;
-
-			if (S >= 0 && T >= 0 && Math::sqrt(S) + Math::sqrt(T) <= 1)
+			if (S >= 0 && T >= 0 && S + T <= 1)
 			{
 				outPoint = p;
-				outNormal = n;
+				outNormal = n.normalized();
 				outDistance = t;
 				return true;
 			}
@@ -162,6 +162,19 @@ namespace Positional
 			return Quat(axis.x*s, axis.y*s, axis.z*s, c);
 		}
 
+		/*
+		 * Normalized linear blend along the shorter arc, close to slerp for the small angles between two steps
+		 */
+		static inline Quat nlerp(const Quat &a, const Quat &b, const Float &t)
+		{
+			const Float s = a.dot(b) < 0 ? -t : t;
+			return Quat(
+				a.x + (b.x * s - a.x * t),
+				a.y + (b.y * s - a.y * t),
+				a.z + (b.z * s - a.z * t),
+				a.w + (b.w * s - a.w * t)).normalized();
+		}
+
 		static const Quat identity;
 	};
 }
@@ -6,7 +6,7 @@ namespace Positional
 
 #ifdef SINGLE_PRECISION
 	const Float Math::Pi = 3.14159265358979323846f;
-	const Float Math::EPSILON = 0.0000001f;
+	const Float Math::Epsilon = 0.0000001f;
 #else
 	const Float Math::Pi = 3.14159265358979323846;
 	const Float Math::Epsilon = 0.000000000000001;
@@ -0,0 +1,256 @@
+/*
+ * Lanes of Float processed with one instruction, for solvers working on several independent items at once.
+ * Uses AVX or SSE2 when the compiler targets them and falls back to a single scalar lane otherwise.
+ * Comparisons return masks with all bits set in true lanes, select and any consume them.
+ */
+#ifndef WIDE_H
+#define WIDE_H
+
+#include "Primitives.h"
+#include "Vec3.h"
+#include "Quat.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#define POSITIONAL_WIDE_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSITIONAL_WIDE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Positional
+{
+	class Wide
+	{
+	public:
+#if defined(POSITIONAL_WIDE_AVX) && defined(SINGLE_PRECISION)
+		typedef __m256 Register;
+		static const UInt32 width = 8;
+#elif defined(POSITIONAL_WIDE_AVX)
+		typedef __m256d Register;
+		static const UInt32 width = 4;
+#elif defined(POSITIONAL_WIDE_SSE) && defined(SINGLE_PRECISION)
+		typedef __m128 Register;
+		static const UInt32 width = 4;
+#elif defined(POSITIONAL_WIDE_SSE)
+		typedef __m128d Register;
+		static const UInt32 width = 2;
+#else
+		typedef Float Register;
+		static const UInt32 width = 1;
+#endif
+		// alignment of arrays passed to load and store
+		static const UInt32 alignment = sizeof(Register);
+
+		Register v;
+
+		Wide() {}
+		Wide(const Register &_v) : v(_v) {}
+#if defined(POSITIONAL_WIDE_AVX) || defined(POSITIONAL_WIDE_SSE)
+		Wide(const Float &s) : v(set1(s)) {}
+#endif
+
+		static inline Wide load(const Float *aligned);
+		inline void store(Float *aligned) const;
+
+		inline Wide operator+(const Wide &rhs) const;
+		inline Wide operator-(const Wide &rhs) const;
+		inline Wide operator*(const Wide &rhs) const;
+		inline Wide operator/(const Wide &rhs) const;
+		inline Wide operator-() const { return Wide(0.0) - *this; }
+
+		inline Wide operator<(const Wide &rhs) const;
+		inline Wide operator>(const Wide &rhs) const;
+		inline Wide operator&(const Wide &rhs) const;
+
+		static inline Wide sqrt(const Wide &a);
+		static inline Wide abs(const Wide &a);
+
+		/*
+		 * Lanes of a where mask is set, b elsewhere
+		 */
+		static inline Wide select(const Wide &mask, const Wide &a, const Wide &b);
+
+		/*
+		 * One bit per lane of mask, lane 0 in the lowest bit
+		 */
+		static inline UInt32 bits(const Wide &mask);
+
+	private:
+#if defined(POSITIONAL_WIDE_AVX) || defined(POSITIONAL_WIDE_SSE)
+		static inline Register set1(const Float &s);
+#endif
+	};
+
+#if defined(POSITIONAL_WIDE_AVX) && defined(SINGLE_PRECISION)
+	inline Wide::Register Wide::set1(const Float &s) { return _mm256_set1_ps(s); }
+	inline Wide Wide::load(const Float *aligned) { return _mm256_load_ps(aligned); }
+	inline void Wide::store(Float *aligned) const { _mm256_store_ps(aligned, v); }
+	inline Wide Wide::operator+(const Wide &rhs) const { return _mm256_add_ps(v, rhs.v); }
+	inline Wide Wide::operator-(const Wide &rhs) const { return _mm256_sub_ps(v, rhs.v); }
+	inline Wide Wide::operator*(const Wide &rhs) const { return _mm256_mul_ps(v, rhs.v); }
+	inline Wide Wide::operator/(const Wide &rhs) const { return _mm256_div_ps(v, rhs.v); }
+	inline Wide Wide::operator<(const Wide &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_LT_OQ); }
+	inline Wide Wide::operator>(const Wide &rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_GT_OQ); }
+	inline Wide Wide::operator&(const Wide &rhs) const { return _mm256_and_ps(v, rhs.v); }
+	inline Wide Wide::sqrt(const Wide &a) { return _mm256_sqrt_ps(a.v); }
+	inline Wide Wide::abs(const Wide &a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+	inline Wide Wide::select(const Wide &mask, const Wide &a, const Wide &b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+	inline UInt32 Wide::bits(const Wide &mask) { return _mm256_movemask_ps(mask.v); }
+#elif defined(POSITIONAL_WIDE_AVX)
+	inline Wide::Register Wide::set1(const Float &s) { return _mm256_set1_pd(s); }
+	inline Wide Wide::load(const Float *aligned) { return _mm256_load_pd(aligned); }
+	inline void Wide::store(Float *aligned) const { _mm256_store_pd(aligned, v); }
+	inline Wide Wide::operator+(const Wide &rhs) const { return _mm256_add_pd(v, rhs.v); }
+	inline Wide Wide::operator-(const Wide &rhs) const { return _mm256_sub_pd(v, rhs.v); }
+	inline Wide Wide::operator*(const Wide &rhs) const { return _mm256_mul_pd(v, rhs.v); }
+	inline Wide Wide::operator/(const Wide &rhs) const { return _mm256_div_pd(v, rhs.v); }
+	inline Wide Wide::operator<(const Wide &rhs) const { return _mm256_cmp_pd(v, rhs.v, _CMP_LT_OQ); }
+	inline Wide Wide::operator>(const Wide &rhs) const { return _mm256_cmp_pd(v, rhs.v, _CMP_GT_OQ); }
+	inline Wide Wide::operator&(const Wide &rhs) const { return _mm256_and_pd(v, rhs.v); }
+	inline Wide Wide::sqrt(const Wide &a) { return _mm256_sqrt_pd(a.v); }
+	inline Wide Wide::abs(const Wide &a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+	inline Wide Wide::select(const Wide &mask, const Wide &a, const Wide &b) { return _mm256_blendv_pd(b.v, a.v, mask.v); }
+	inline UInt32 Wide::bits(const Wide &mask) { return _mm256_movemask_pd(mask.v); }
+#elif defined(POSITIONAL_WIDE_SSE) && defined(SINGLE_PRECISION)
+	inline Wide::Register Wide::set1(const Float &s) { return _mm_set1_ps(s); }
+	inline Wide Wide::load(const Float *aligned) { return _mm_load_ps(aligned); }
+	inline void Wide::store(Float *aligned) const { _mm_store_ps(aligned, v); }
+	inline Wide Wide::operator+(const Wide &rhs) const { return _mm_add_ps(v, rhs.v); }
+	inline Wide Wide::operator-(const Wide &rhs) const { return _mm_sub_ps(v, rhs.v); }
+	inline Wide Wide::operator*(const Wide &rhs) const { return _mm_mul_ps(v, rhs.v); }
+	inline Wide Wide::operator/(const Wide &rhs) const { return _mm_div_ps(v, rhs.v); }
+	inline Wide Wide::operator<(const Wide &rhs) const { return _mm_cmplt_ps(v, rhs.v); }
+	inline Wide Wide::operator>(const Wide &rhs) const { return _mm_cmpgt_ps(v, rhs.v); }
+	inline Wide Wide::operator&(const Wide &rhs) const { return _mm_and_ps(v, rhs.v); }
+	inline Wide Wide::sqrt(const Wide &a) { return _mm_sqrt_ps(a.v); }
+	inline Wide Wide::abs(const Wide &a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+	// SSE2 has no blend instruction
+	inline Wide Wide::select(const Wide &mask, const Wide &a, const Wide &b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+	inline UInt32 Wide::bits(const Wide &mask) { return _mm_movemask_ps(mask.v); }
+#elif defined(POSITIONAL_WIDE_SSE)
+	inline Wide::Register Wide::set1(const Float &s) { return _mm_set1_pd(s); }
+	inline Wide Wide::load(const Float *aligned) { return _mm_load_pd(aligned); }
+	inline void Wide::store(Float *aligned) const { _mm_store_pd(aligned, v); }
+	inline Wide Wide::operator+(const Wide &rhs) const { return _mm_add_pd(v, rhs.v); }
+	inline Wide Wide::operator-(const Wide &rhs) const { return _mm_sub_pd(v, rhs.v); }
+	inline Wide Wide::operator*(const Wide &rhs) const { return _mm_mul_pd(v, rhs.v); }
+	inline Wide Wide::operator/(const Wide &rhs) const { return _mm_div_pd(v, rhs.v); }
+	inline Wide Wide::operator<(const Wide &rhs) const { return _mm_cmplt_pd(v, rhs.v); }
+	inline Wide Wide::operator>(const Wide &rhs) const { return _mm_cmpgt_pd(v, rhs.v); }
+	inline Wide Wide::operator&(const Wide &rhs) const { return _mm_and_pd(v, rhs.v); }
+	inline Wide Wide::sqrt(const Wide &a) { return _mm_sqrt_pd(a.v); }
+	inline Wide Wide::abs(const Wide &a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+	// SSE2 has no blend instruction
+	inline Wide Wide::select(const Wide &mask, const Wide &a, const Wide &b) { return _mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v)); }
+	inline UInt32 Wide::bits(const Wide &mask) { return _mm_movemask_pd(mask.v); }
+#else
+	// a single lane, masks are 1 or 0
+	inline Wide Wide::load(const Float *aligned) { return *aligned; }
+	inline void Wide::store(Float *aligned) const { *aligned = v; }
+	inline Wide Wide::operator+(const Wide &rhs) const { return v + rhs.v; }
+	inline Wide Wide::operator-(const Wide &rhs) const { return v - rhs.v; }
+	inline Wide Wide::operator*(const Wide &rhs) const { return v * rhs.v; }
+	inline Wide Wide::operator/(const Wide &rhs) const { return v / rhs.v; }
+	inline Wide Wide::operator<(const Wide &rhs) const { return v < rhs.v ? 1.0 : 0.0; }
+	inline Wide Wide::operator>(const Wide &rhs) const { return v > rhs.v ? 1.0 : 0.0; }
+	inline Wide Wide::operator&(const Wide &rhs) const { return v != 0 && rhs.v != 0 ? 1.0 : 0.0; }
+	inline Wide Wide::sqrt(const Wide &a) { return std::sqrt(a.v); }
+	inline Wide Wide::abs(const Wide &a) { return std::abs(a.v); }
+	inline Wide Wide::select(const Wide &mask, const Wide &a, const Wide &b) { return mask.v != 0 ? a : b; }
+	inline UInt32 Wide::bits(const Wide &mask) { return mask.v != 0 ? 1 : 0; }
+#endif
+
+	class WideVec3
+	{
+	public:
+		Wide x, y, z;
+
+		WideVec3() {}
+		WideVec3(const Wide &_x, const Wide &_y, const Wide &_z) : x(_x), y(_y), z(_z) {}
+
+		inline WideVec3 operator+(const WideVec3 &rhs) const { return WideVec3(x + rhs.x, y + rhs.y, z + rhs.z); }
+		inline WideVec3 operator-(const WideVec3 &rhs) const { return WideVec3(x - rhs.x, y - rhs.y, z - rhs.z); }
+		inline WideVec3 operator*(const WideVec3 &rhs) const { return WideVec3(x * rhs.x, y * rhs.y, z * rhs.z); }
+		inline WideVec3 operator*(const Wide &rhs) const { return WideVec3(x * rhs, y * rhs, z * rhs); }
+		inline WideVec3 operator-() const { return WideVec3(-x, -y, -z); }
+
+		inline Wide dot(const WideVec3 &rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
+		inline Wide lengthSq() const { return dot(*this); }
+
+		inline WideVec3 cross(const WideVec3 &rhs) const
+		{
+			return WideVec3(
+				y * rhs.z - z * rhs.y,
+				z * rhs.x - x * rhs.z,
+				x * rhs.y - y * rhs.x);
+		}
+
+		static inline WideVec3 select(const Wide &mask, const WideVec3 &a, const WideVec3 &b)
+		{
+			return WideVec3(Wide::select(mask, a.x, b.x), Wide::select(mask, a.y, b.y), Wide::select(mask, a.z, b.z));
+		}
+	};
+
+	class WideQuat
+	{
+	public:
+		Wide x, y, z, w;
+
+		WideQuat() {}
+		WideQuat(const Wide &_x, const Wide &_y, const Wide &_z, const Wide &_w) : x(_x), y(_y), z(_z), w(_w) {}
+
+		inline WideQuat operator*(const WideQuat &rhs) const
+		{
+			return WideQuat(
+				w * rhs.x + rhs.w * x + y * rhs.z - rhs.y * z,
+				w * rhs.y + rhs.w * y + z * rhs.x - rhs.z * x,
+				w * rhs.z + rhs.w * z + x * rhs.y - rhs.x * y,
+				w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z);
+		}
+
+		inline WideQuat conjugate() const { return WideQuat(-x, -y, -z, w); }
+
+		inline WideQuat normalized() const
+		{
+			const Wide invNorm = Wide(1.0) / Wide::sqrt(x * x + y * y + z * z + w * w);
+			return WideQuat(x * invNorm, y * invNorm, z * invNorm, w * invNorm);
+		}
+
+		/*
+		 * Same expansion as Quat * Vec3
+		 */
+		inline WideVec3 rotate(const WideVec3 &v) const
+		{
+			const Wide one(1.0);
+			const Wide x2 = x + x;
+			const Wide y2 = y + y;
+			const Wide z2 = z + z;
+
+			const Wide wx2 = w * x2;
+			const Wide wy2 = w * y2;
+			const Wide wz2 = w * z2;
+			const Wide xx2 = x * x2;
+			const Wide xy2 = x * y2;
+			const Wide xz2 = x * z2;
+			const Wide yy2 = y * y2;
+			const Wide yz2 = y * z2;
+			const Wide zz2 = z * z2;
+
+			return WideVec3(
+				v.x * (one - yy2 - zz2) + v.y * (xy2 - wz2) + v.z * (xz2 + wy2),
+				v.x * (xy2 + wz2) + v.y * (one - xx2 - zz2) + v.z * (yz2 - wx2),
+				v.x * (xz2 - wy2) + v.y * (yz2 + wx2) + v.z * (one - xx2 - yy2));
+		}
+
+		inline WideVec3 inverseRotate(const WideVec3 &v) const { return conjugate().rotate(v); }
+
+		static inline WideQuat select(const Wide &mask, const WideQuat &a, const WideQuat &b)
+		{
+			return WideQuat(Wide::select(mask, a.x, b.x), Wide::select(mask, a.y, b.y), Wide::select(mask, a.z, b.z), Wide::select(mask, a.w, b.w));
+		}
+	};
+}
+
+#endif // WIDE_H
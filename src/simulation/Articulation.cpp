@@ -0,0 +1,453 @@
+#include "Articulation.h"
+#include <algorithm>
+
+namespace Positional
+{
+	// rows and columns of the node blocks
+	const UInt32 k_stride = 6;
+
+	/*
+	 * Cholesky factor of a positive definite block in its lower triangle
+	 */
+	inline bool factorBlock(Float *a, const UInt32 &n)
+	{
+		for (UInt32 j = 0; j < n; ++j)
+		{
+			Float d = a[j * k_stride + j];
+			for (UInt32 k = 0; k < j; ++k)
+			{
+				d -= a[j * k_stride + k] * a[j * k_stride + k];
+			}
+
+			if (!(d > 0))
+			{
+				return false;
+			}
+
+			d = Math::sqrt(d);
+			a[j * k_stride + j] = d;
+			for (UInt32 i = j + 1; i < n; ++i)
+			{
+				Float s = a[i * k_stride + j];
+				for (UInt32 k = 0; k < j; ++k)
+				{
+					s -= a[i * k_stride + k] * a[j * k_stride + k];
+				}
+				a[i * k_stride + j] = s / d;
+			}
+		}
+		return true;
+	}
+
+	inline void solveBlock(const Float *l, const UInt32 &n, Float *x)
+	{
+		for (UInt32 i = 0; i < n; ++i)
+		{
+			Float s = x[i];
+			for (UInt32 k = 0; k < i; ++k)
+			{
+				s -= l[i * k_stride + k] * x[k];
+			}
+			x[i] = s / l[i * k_stride + i];
+		}
+
+		for (UInt32 i = n; i-- > 0;)
+		{
+			Float s = x[i];
+			for (UInt32 k = i + 1; k < n; ++k)
+			{
+				s -= l[k * k_stride + i] * x[k];
+			}
+			x[i] = s / l[i * k_stride + i];
+		}
+	}
+
+	inline UInt32 rowCount(const UInt8 &dof)
+	{
+		if (dof == 0)
+		{
+			return 6;
+		}
+		return (dof & DOF::Swing) == DOF::Swing ? 3 : 5;
+	}
+
+	inline Vec3 centerOfMass(const Body &body)
+	{
+		return body.pose.transform(body.massPose.position);
+	}
+
+	/*
+	 * Writes one joint row, its linear and angular part on both bodies
+	 */
+	inline void setRow(Float *rowB, Float *rowA, const Vec3 &linear, const Vec3 &angularB, const Vec3 &angularA)
+	{
+		rowB[0] = linear.x; rowB[1] = linear.y; rowB[2] = linear.z;
+		rowB[3] = angularB.x; rowB[4] = angularB.y; rowB[5] = angularB.z;
+		rowA[0] = -linear.x; rowA[1] = -linear.y; rowA[2] = -linear.z;
+		rowA[3] = -angularA.x; rowA[4] = -angularA.y; rowA[5] = -angularA.z;
+	}
+
+	// world space frame in the space of a body
+	inline Pose toLocal(const Pose &body, const Pose &frame)
+	{
+		return Pose(body.inverseTransform(frame.position), body.rotation.conjugate() * frame.rotation);
+	}
+
+	Articulation::Articulation() :
+		m_active(false),
+		m_ignoreCollisions(false),
+		iterations(2)
+	{
+	}
+
+	UInt32 Articulation::addRoot(const Ref<Body> &body)
+	{
+		assert(m_links.empty());
+		addLink(body, NOT_FOUND, body.get().pose, 0, 0);
+		m_links.back().jointed = false;
+		return 0;
+	}
+
+	UInt32 Articulation::addLink(const Ref<Body> &body, const UInt32 &parent, const Pose &joint, const UInt8 &dof, const Float &compliance)
+	{
+		assert(body.valid() && body.get().invMass > 0 && !contains(body));
+		// the mass matrix inverts the inertia, an axis without it would divide by zero
+		assert(body.get().invInertia.x > 0 && body.get().invInertia.y > 0 && body.get().invInertia.z > 0);
+		assert(parent == NOT_FOUND ? m_links.empty() : parent < m_links.size());
+		assert(dof == 0 || dof == DOF::Twist || dof == (DOF::Swing | DOF::Twist));
+
+		Link link;
+		link.body = body;
+		link.parent = parent;
+		link.dof = dof;
+		link.jointed = true;
+		link.compliance = compliance;
+		link.resolved = &Body::immovable;
+
+		link.frameA = parent != NOT_FOUND ? toLocal(m_links[parent].body.get().pose, joint) : joint;
+		link.frameB = toLocal(body.get().pose, joint);
+
+		m_links.push_back(link);
+		m_nodes.clear();
+		return m_links.size() - 1;
+	}
+
+	/*
+	 * Each link is followed by its joint, links are added after their parents so walking
+	 * them backwards puts every node before its parent
+	 */
+	void Articulation::layout()
+	{
+		m_nodes.clear();
+		for (UInt32 i = m_links.size(); i-- > 0;)
+		{
+			Link &link = m_links[i];
+			link.bodyNode = m_nodes.size();
+			m_nodes.push_back(Node());
+			m_nodes.back().size = 6;
+			m_nodes.back().sign = 1;
+
+			link.jointNode = NOT_FOUND;
+			if (link.jointed)
+			{
+				link.jointNode = m_nodes.size();
+				m_nodes.push_back(Node());
+				m_nodes.back().size = rowCount(link.dof);
+				m_nodes.back().sign = -1;
+			}
+		}
+
+		for (const Link &link : m_links)
+		{
+			m_nodes[link.bodyNode].parent = link.jointNode;
+			if (link.jointed)
+			{
+				m_nodes[link.jointNode].parent = link.parent != NOT_FOUND ? m_links[link.parent].bodyNode : NOT_FOUND;
+			}
+		}
+	}
+
+	void Articulation::resolve(Store<Body> &bodies)
+	{
+		bool awake = false;
+		bool massive = true;
+		for (Link &link : m_links)
+		{
+			link.resolved = &bodies[link.body.index()];
+			awake |= !link.resolved->isSleeping();
+			const Vec3 &invInertia = link.resolved->invInertia;
+			massive &= link.resolved->invMass > 0 && invInertia.x > 0 && invInertia.y > 0 && invInertia.z > 0;
+		}
+
+		// the links share an island, a link woken on its own brings the others along
+		if (awake)
+		{
+			for (Link &link : m_links)
+			{
+				// waking resets the sleep timer, awake links keep theirs
+				if (link.resolved->isSleeping())
+				{
+					link.resolved->wake();
+				}
+			}
+		}
+
+		if (m_nodes.empty() && !m_links.empty())
+		{
+			layout();
+		}
+		m_active = awake && massive;
+	}
+
+	/*
+	 * Mass matrices of the bodies, joint rows and their errors as in
+	 * [M J^T; J -compliance] [dx; -dlambda] = [0; -C - compliance lambda]
+	 */
+	void Articulation::assemble(const Float &dtInvSq)
+	{
+		for (Link &link : m_links)
+		{
+			const Body &body = *link.resolved;
+			Node &node = m_nodes[link.bodyNode];
+			std::fill(node.block, node.block + 36, 0);
+			std::fill(node.x, node.x + 6, 0);
+
+			const Float mass = 1 / body.invMass;
+			node.block[0] = node.block[7] = node.block[14] = mass;
+
+			// world inertia R I R^T column by column
+			const Quat rotation = body.pose.rotation * body.massPose.rotation;
+			const Quat inverse = rotation.inverse();
+			for (UInt32 c = 0; c < 3; ++c)
+			{
+				Vec3 axis = Vec3::zero;
+				axis[c] = 1;
+				Vec3 local = inverse * axis;
+				local.x /= body.invInertia.x;
+				local.y /= body.invInertia.y;
+				local.z /= body.invInertia.z;
+				const Vec3 column = rotation * local;
+				node.block[3 * k_stride + 3 + c] = column.x;
+				node.block[4 * k_stride + 3 + c] = column.y;
+				node.block[5 * k_stride + 3 + c] = column.z;
+			}
+		}
+
+		for (Link &link : m_links)
+		{
+			if (!link.jointed)
+			{
+				continue;
+			}
+
+			const Body &bodyB = *link.resolved;
+			const Body *bodyA = link.parent != NOT_FOUND ? m_links[link.parent].resolved : nullptr;
+			Node &node = m_nodes[link.jointNode];
+			const UInt32 size = node.size;
+			const Float alpha = link.compliance * dtInvSq;
+
+			std::fill(node.block, node.block + 36, 0);
+			for (UInt32 r = 0; r < size; ++r)
+			{
+				node.block[r * k_stride + r] = -alpha;
+			}
+
+			// rows on the link and its parent, the link's rows are stored transposed as its coupling
+			Float rowsB[36];
+			Float rowsA[36];
+			Float error[6];
+
+			const Vec3 posB = bodyB.pose.transform(link.frameB.position);
+			const Vec3 posA = bodyA != nullptr ? bodyA->pose.transform(link.frameA.position) : link.frameA.position;
+			const Vec3 rB = posB - centerOfMass(bodyB);
+			const Vec3 rA = bodyA != nullptr ? posA - centerOfMass(*bodyA) : Vec3::zero;
+			Vec3 offset = posB - posA;
+			for (UInt32 k = 0; k < 3; ++k)
+			{
+				Vec3 axis = Vec3::zero;
+				axis[k] = 1;
+				setRow(&rowsB[k * k_stride], &rowsA[k * k_stride], axis, rB.cross(axis), rA.cross(axis));
+				error[k] = offset[k];
+			}
+
+			if (size > 3)
+			{
+				const Quat rotB = bodyB.pose.rotation * link.frameB.rotation;
+				const Quat rotA = bodyA != nullptr ? bodyA->pose.rotation * link.frameA.rotation : link.frameA.rotation;
+				if (link.dof == 0)
+				{
+					// same rotation error as a fixed GenericJointConstraint
+					const Quat q = rotB * rotA.conjugate();
+					Vec3 omega = q.w < 0.0 ? Vec3(-2.0 * q.x, -2.0 * q.y, -2.0 * q.z) : Vec3(2.0 * q.x, 2.0 * q.y, 2.0 * q.z);
+					for (UInt32 k = 0; k < 3; ++k)
+					{
+						Vec3 axis = Vec3::zero;
+						axis[k] = 1;
+						setRow(&rowsB[(3 + k) * k_stride], &rowsA[(3 + k) * k_stride], Vec3::zero, axis, axis);
+						error[3 + k] = omega[k];
+					}
+				}
+				else
+				{
+					// hinge axes aligned, measured across the two directions perpendicular to the parent's axis
+					const Vec3 axb = (rotA * Vec3::pos_x).cross(rotB * Vec3::pos_x);
+					const Vec3 tangents[2] = {rotA * Vec3::pos_y, rotA * Vec3::pos_z};
+					for (UInt32 k = 0; k < 2; ++k)
+					{
+						setRow(&rowsB[(3 + k) * k_stride], &rowsA[(3 + k) * k_stride], Vec3::zero, tangents[k], tangents[k]);
+						error[3 + k] = axb.dot(tangents[k]);
+					}
+				}
+			}
+
+			for (UInt32 r = 0; r < size; ++r)
+			{
+				node.x[r] = -error[r] - alpha * link.lambda[r];
+				if (bodyA != nullptr)
+				{
+					std::copy(&rowsA[r * k_stride], &rowsA[r * k_stride] + 6, &node.coupling[r * k_stride]);
+				}
+
+				Node &child = m_nodes[link.bodyNode];
+				for (UInt32 c = 0; c < 6; ++c)
+				{
+					child.coupling[c * k_stride + r] = rowsB[r * k_stride + c];
+				}
+			}
+		}
+	}
+
+	/*
+	 * Block elimination from the leaves to the root, then substitution from the root back to the leaves,
+	 * with D the diagonal, H the coupling to the parent and J = D^-1 H:
+	 * D_parent -= H^T J and x_parent -= J^T x on the way up, x = D^-1 x - J x_parent on the way down
+	 */
+	bool Articulation::factorAndSolve()
+	{
+		for (Node &node : m_nodes)
+		{
+			const UInt32 n = node.size;
+			for (UInt32 i = 0; i < n * k_stride; ++i)
+			{
+				node.block[i] *= node.sign;
+			}
+
+			if (!factorBlock(node.block, n))
+			{
+				return false;
+			}
+
+			if (node.parent == NOT_FOUND)
+			{
+				continue;
+			}
+
+			Node &parent = m_nodes[node.parent];
+			const UInt32 m = parent.size;
+			Float solved[36];
+			for (UInt32 c = 0; c < m; ++c)
+			{
+				Float column[6];
+				for (UInt32 r = 0; r < n; ++r)
+				{
+					column[r] = node.coupling[r * k_stride + c];
+				}
+
+				solveBlock(node.block, n, column);
+				for (UInt32 r = 0; r < n; ++r)
+				{
+					solved[r * k_stride + c] = node.sign * column[r];
+				}
+			}
+
+			for (UInt32 a = 0; a < m; ++a)
+			{
+				for (UInt32 b = 0; b < m; ++b)
+				{
+					Float s = 0;
+					for (UInt32 r = 0; r < n; ++r)
+					{
+						s += node.coupling[r * k_stride + a] * solved[r * k_stride + b];
+					}
+					parent.block[a * k_stride + b] -= s;
+				}
+
+				Float s = 0;
+				for (UInt32 r = 0; r < n; ++r)
+				{
+					s += solved[r * k_stride + a] * node.x[r];
+				}
+				parent.x[a] -= s;
+			}
+
+			std::copy(solved, solved + 36, node.coupling);
+		}
+
+		for (UInt32 i = m_nodes.size(); i-- > 0;)
+		{
+			Node &node = m_nodes[i];
+			const UInt32 n = node.size;
+			solveBlock(node.block, n, node.x);
+			for (UInt32 r = 0; r < n; ++r)
+			{
+				node.x[r] *= node.sign;
+			}
+
+			if (node.parent == NOT_FOUND)
+			{
+				continue;
+			}
+
+			const Node &parent = m_nodes[node.parent];
+			for (UInt32 r = 0; r < n; ++r)
+			{
+				Float s = 0;
+				for (UInt32 c = 0; c < parent.size; ++c)
+				{
+					s += node.coupling[r * k_stride + c] * parent.x[c];
+				}
+				node.x[r] -= s;
+			}
+		}
+		return true;
+	}
+
+	void Articulation::solvePositions(const Float &dtInvSq)
+	{
+		if (!m_active)
+		{
+			return;
+		}
+
+		for (Link &link : m_links)
+		{
+			std::fill(link.lambda, link.lambda + 6, 0);
+		}
+
+		for (UInt32 i = 0; i < iterations; ++i)
+		{
+			assemble(dtInvSq);
+			if (!factorAndSolve())
+			{
+				return;
+			}
+
+			for (Link &link : m_links)
+			{
+				const Node &node = m_nodes[link.bodyNode];
+				Body &body = *link.resolved;
+				body.pose.position += Vec3(node.x[0], node.x[1], node.x[2]);
+				body.applyRotation(Vec3(node.x[3], node.x[4], node.x[5]));
+
+				if (link.jointed)
+				{
+					const Node &joint = m_nodes[link.jointNode];
+					for (UInt32 r = 0; r < joint.size; ++r)
+					{
+						link.lambda[r] -= joint.x[r];
+					}
+				}
+			}
+		}
+	}
+}
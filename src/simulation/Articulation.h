@@ -0,0 +1,111 @@
+/*
+ * Tree of bodies whose joints are solved together, one direct solve per substep instead of Gauss-Seidel sweeps.
+ * Bodies and joint rows form a tree, so eliminating leaves first factors the whole system in time linear
+ * in the number of links. Long chains stay stiff at a few substeps where chains of joints stretch.
+ * Links stay ordinary bodies, the articulation is solved after contacts and other joints so its joints end every substep closed.
+ */
+#ifndef ARTICULATION_H
+#define ARTICULATION_H
+
+#include "math/Math.h"
+#include "data/Store.h"
+#include "constraints/GenericJointConstraint.h"
+#include "Body.h"
+#include <vector>
+
+using namespace std;
+
+namespace Positional
+{
+	class Articulation
+	{
+		friend class World;
+	private:
+		struct Link
+		{
+			Ref<Body> body;
+			// NOT_FOUND for the root
+			UInt32 parent;
+			// joint frame in parent and link body space, the parent frame is in world space for an anchored root
+			Pose frameA;
+			Pose frameB;
+			UInt8 dof;
+			bool jointed;
+			Float compliance;
+
+			// resolved by the world at the start of every step
+			Body *resolved;
+			UInt32 bodyNode;
+			UInt32 jointNode;
+			Float lambda[6];
+		};
+
+		/*
+		 * Body or joint in the elimination tree, blocks are row major with six columns whatever their size
+		 */
+		struct Node
+		{
+			UInt32 size;
+			UInt32 parent;
+			// bodies are positive definite, joints negative definite
+			Float sign;
+			// diagonal block, factored in place
+			Float block[36];
+			// block coupling to the parent, size by parent size, replaced by the block solved against the diagonal
+			Float coupling[36];
+			Float x[6];
+		};
+
+		vector<Link> m_links;
+		// children before parents, the last node is the root of the tree
+		vector<Node> m_nodes;
+		bool m_active;
+		bool m_ignoreCollisions;
+
+		void layout();
+		void assemble(const Float &dtInvSq);
+		bool factorAndSolve();
+
+		/*
+		 * Called by the world, resolve once per step and solvePositions once per substep
+		 */
+		void resolve(Store<Body> &bodies);
+		void solvePositions(const Float &dtInvSq);
+
+	public:
+		// direct solves per substep, each relinearizes the joints, heavy links swinging fast at few substeps need more
+		UInt32 iterations;
+
+		Articulation();
+
+		/*
+		 * Free root of the tree, all other links hang off it
+		 */
+		UInt32 addRoot(const Ref<Body> &body);
+
+		/*
+		 * Adds a link jointed to an earlier link, or to the world with parent NOT_FOUND as the first link.
+		 * The joint frame is given in world space and taken as the rest pose, its x axis is the hinge axis.
+		 * Joints are fixed without dof, hinges with DOF::Twist and ball joints with DOF::Swing | DOF::Twist,
+		 * compliance is inverse stiffness as in Constraint::computeCorrections.
+		 * Links need mass and inertia about every axis, an articulation whose link lost either is not solved.
+		 */
+		UInt32 addLink(const Ref<Body> &body, const UInt32 &parent, const Pose &joint, const UInt8 &dof = 0, const Float &compliance = 0);
+
+		inline UInt32 count() const { return m_links.size(); }
+		inline const Ref<Body> &body(const UInt32 &link) const { return m_links[link].body; }
+		inline UInt32 parent(const UInt32 &link) const { return m_links[link].parent; }
+		inline bool contains(const Ref<Body> &body) const
+		{
+			for (const Link &link : m_links)
+			{
+				if (link.body == body)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
+#endif // ARTICULATION_H
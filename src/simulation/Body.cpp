@@ -1,4 +1,5 @@
 #include "Body.h"
+#include "RigidBody.h"
 #include "mass/Computer.h"
 #include <stdexcept>
 
@@ -6,20 +7,42 @@ namespace Positional
 {
 	const Ref<Body> Body::null = Ref<Body>();
 
+	// built from literals, other statics such as Quat::identity may not be initialized yet
+	inline Body makeImmovable()
+	{
+		Body body = Body::create<RigidBody>(nullptr, Vec3(0, 0, 0), Quat());
+		body.prePose = Pose(Vec3(0, 0, 0), Quat(), true);
+		body.massPose = Pose(Vec3(0, 0, 0), Quat(), true);
+		body.sleep();
+		return body;
+	}
+	Body Body::immovable = makeImmovable();
+
 	bool Body::updateMass()
 	{
+		static const Vec3 axes[6] = {Vec3::pos_x, Vec3::neg_x, Vec3::pos_y, Vec3::neg_y, Vec3::pos_z, Vec3::neg_z};
+
 		Mass::Computer computer;
+		m_ccdRadius = m_colliders.size() > 0 ? FLOAT_MAX : 0;
 		for (UInt32 i = 0, count = m_colliders.size(); i < count; ++i)
 		{
+			const Collider &collider = m_colliders[i].get();
 			Mass::Computer it;
-			m_colliders[i].get().computeMass(it);
+			collider.computeMass(it);
 			computer.add(it);
+
+			for (UInt32 a = 0; a < 6; ++a)
+			{
+				m_ccdRadius = Math::min(m_ccdRadius, collider.localSupport(axes[a]).dot(axes[a]));
+			}
 		}
+		m_ccdRadius = Math::max(m_ccdRadius, 0);
 
 		Vec3 com, inertia;
 		Quat rot;
 		Float mass;
-		if (computer.diagonalize(inertia, rot, com, mass))
+		// kinematic bodies turn about their origin and have infinite mass
+		if (!m_kinematic && computer.diagonalize(inertia, rot, com, mass))
 		{
 			massPose.position = com;
 			massPose.rotation = rot;
@@ -37,6 +60,11 @@ namespace Positional
 
 	Float Body::getInverseMass(const Vec3 &normal, const optional<Vec3> &pos)
 	{
+		if (m_sleeping || m_kinematic)
+		{
+			return 0;
+		}
+
 		Vec3 n = normal;
 		Float w = 0;
 		if (pos.has_value())
@@ -79,10 +107,16 @@ namespace Positional
 		// maintain center of mass position in world space
 		const Vec3 offset = pose.transform(massPose.position) - pose.position;
 		pose.position = worldCOM - offset;
+		m_poseVersion++;
 	}
 
 	void Body::applyCorrection(const Vec3 &correction, const optional<Vec3> &pos, const bool &velLevel)
 	{
+		if (m_sleeping || m_kinematic)
+		{
+			return;
+		}
+
 		Vec3 dq;
 		if (pos.has_value())
 		{
@@ -93,6 +127,7 @@ namespace Positional
 			else
 			{
 				pose.position = pose.position + correction * invMass;
+				m_poseVersion++;
 			}
 
 			dq = (pos.value() - pose.transform(massPose.position)).cross(correction);
@@ -117,4 +152,47 @@ namespace Positional
 			applyRotation(dq);
 		}
 	}
+
+	void Body::moveTo(const Pose &target)
+	{
+		assert(m_kinematic);
+		wake();
+		m_target = target;
+	}
+
+	/*
+	 * Velocities that carry the pose to the target in one step, the shorter way round
+	 */
+	void Body::aimAtTarget(const Float &dtInv)
+	{
+		if (!m_target.has_value())
+		{
+			return;
+		}
+
+		velocity.linear = (m_target->position - pose.position) * dtInv;
+
+		const Quat dq = m_target->rotation * pose.rotation.inverse();
+		const Vec3 axis = dq.w >= 0 ? Vec3(dq.x, dq.y, dq.z) : Vec3(-dq.x, -dq.y, -dq.z);
+		const Float sinHalf = axis.length();
+		velocity.angular = sinHalf > Math::Epsilon ?
+			axis * (2 * Math::asin(Math::min(sinHalf, 1)) * dtInv / sinHalf) :
+			axis * (2 * dtInv);
+	}
+
+	/*
+	 * Removes what integrating the velocities left over
+	 */
+	void Body::reachTarget()
+	{
+		if (!m_target.has_value())
+		{
+			return;
+		}
+
+		pose = m_target.value();
+		m_target.reset();
+		velocity.linear = velocity.angular = Vec3::zero;
+		m_poseVersion++;
+	}
 }
\ No newline at end of file
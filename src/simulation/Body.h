@@ -21,26 +21,54 @@ namespace Positional
 	private:
 		optional<World *> m_world;
 		vector<Ref<Collider>> m_colliders;
+		Float m_ccdRadius;
+		bool m_sleeping;
+		// driven by the user, never moved by the solver
+		bool m_kinematic;
+		// pose a kinematic body reaches at the end of the next step
+		optional<Pose> m_target;
+		// time spent below the sleep velocity thresholds
+		Float m_sleepTimer;
+		// changes whenever the solver moves the pose, collider transform caches compare against it
+		UInt32 m_poseVersion;
 
-		void (*m_integrate)(Body &, const Float &, const Vec3 &);
-		void (*m_differentiate)(Body &, const Float &);
+		// kernels of the body type, each runs over a batch of awake bodies of that type
+		void (*m_integrate)(Body *const *, const UInt32 &, const Float &, const Vec3 &);
+		void (*m_differentiate)(Body *const *, const UInt32 &, const Float &);
+
+		// pose before the last fixed step of World::advance
+		Pose m_previousPose;
+
+		/*
+		 * Called by the world for kinematic bodies with a target, before and after a step
+		 */
+		void aimAtTarget(const Float &dtInv);
+		void reachTarget();
 
 		Body(
 			World *world,
 			const Vec3& position,
 			const Quat& rotation,
 			const bool& hasRotation,
-			void (*integrate)(Body &, const Float &, const Vec3 &),
-			void (*differentiate)(Body&, const Float&)
+			const bool& kinematic,
+			void (*integrate)(Body *const *, const UInt32 &, const Float &, const Vec3 &),
+			void (*differentiate)(Body *const *, const UInt32 &, const Float &)
 		) :
 			m_world(world),
+			m_ccdRadius(0),
+			m_sleeping(false),
+			m_kinematic(kinematic),
+			m_sleepTimer(0),
+			m_poseVersion(0),
 			m_integrate(integrate),
 			m_differentiate(differentiate),
+			m_previousPose(position, rotation, hasRotation),
 			pose(position, rotation, hasRotation),
 			prePose(hasRotation),
 			massPose(hasRotation),
 			invMass(0),
-			invInertia(0) {}
+			invInertia(0),
+			ccd(false) {}
 	public:
 		// position
 		Pose pose;
@@ -56,21 +84,43 @@ namespace Positional
 		Float invMass;
 		Vec3 invInertia;
 
+		// continuous collision detection, clamps motion to the time of impact so fast bodies do not tunnel
+		bool ccd;
+
 		const std::optional<World *> &world() const { return m_world; };
 		const std::vector<Ref<Collider>> &colliders() const { return m_colliders; }
 
+		/*
+		 * Smallest half thickness of the colliders, motion below this is left to the discrete contacts
+		 */
+		inline Float ccdRadius() const { return m_ccdRadius; }
+
 		inline void integrate(const Float &dt, const Vec3 &gravity)
 		{
-			prePose = pose;
-			m_integrate(*this, dt, gravity);
-			forces.linear = Vec3::zero;
-			forces.angular = Vec3::zero;
+			if (m_sleeping)
+			{
+				return;
+			}
+
+			Body *body = this;
+			m_integrate(&body, 1, dt, gravity);
 		}
 		inline void differentiate(const Float &dtInv)
 		{
-			preVelocity = velocity;
-			m_differentiate(*this, dtInv);
+			if (m_sleeping)
+			{
+				return;
+			}
+
+			Body *body = this;
+			m_differentiate(&body, 1, dtInv);
 		}
+		/*
+		 * Sets the velocity so a kinematic body reaches target at the end of the next step, where it then stops.
+		 * Without a target kinematic bodies keep moving at their velocity.
+		 */
+		void moveTo(const Pose &target);
+
 		/*
 		 * return inverse mass scaler at normal and optional point in world space
 		 */
@@ -88,14 +138,57 @@ namespace Positional
 
 		inline void applyForce(const Vec3 &force)
 		{
+			wake();
 			forces.linear += force;
 		}
 
 		inline void applyTorque(const Vec3 &torque)
 		{
+			wake();
 			forces.angular += torque;
 		}
 
+		/*
+		 * Sleeping bodies are not integrated and act as static in constraints until woken
+		 */
+		inline bool isSleeping() const { return m_sleeping; }
+
+		/*
+		 * Kinematic bodies have infinite mass, constraints read their pose and velocity and never correct them
+		 */
+		inline bool isKinematic() const { return m_kinematic; }
+
+		/*
+		 * Call after writing pose while a step runs, so cached collider transforms follow
+		 */
+		inline void poseChanged() { m_poseVersion++; }
+		inline UInt32 poseVersion() const { return m_poseVersion; }
+
+		/*
+		 * Pose blended from the one before the last fixed step to the current one, see World::advance
+		 */
+		inline Pose interpolatedPose(const Float &alpha) const
+		{
+			return Pose(
+				m_previousPose.position + (pose.position - m_previousPose.position) * alpha,
+				Quat::nlerp(m_previousPose.rotation, pose.rotation, alpha),
+				pose.usesRotation);
+		}
+
+		inline void sleep()
+		{
+			m_sleeping = true;
+			velocity.linear = velocity.angular = Vec3::zero;
+			preVelocity = velocity;
+			prePose = pose;
+		}
+
+		inline void wake()
+		{
+			m_sleeping = false;
+			m_sleepTimer = 0;
+		}
+
 		/*
 		 * applies a rotation around the center of mass
 		 */
@@ -111,7 +204,7 @@ namespace Positional
 		template <typename T>
 		static Body create(World *world, const Vec3 &position, const Quat &rotation)
 		{
-			return Body(world, position, rotation, T::hasRotation(), T::integrate, T::differentiate);
+			return Body(world, position, rotation, T::hasRotation(), T::isKinematic(), T::integrate, T::differentiate);
 		}
 
 		static inline Vec3 pointToWorld(const Ref<Body> &body, const Vec3 &point)
@@ -162,6 +255,12 @@ namespace Positional
 		}
 
 		static const Ref<Body> null;
+
+		/*
+		 * Stands in for static bodies while a step runs. It has no mass, an identity pose and always sleeps,
+		 * so solvers only ever read from it and can skip checking for static bodies.
+		 */
+		static Body immovable;
 	};
 }
 #endif // BODY_H
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "ConstraintColoring.h"
+#include <algorithm>
+
+namespace Positional
+{
+	const UInt32 ConstraintColoring::k_maxColors;
+	const UInt32 ConstraintColoring::k_maxBodies;
+
+	inline UInt32 lowestFreeColor(const UInt64 &used)
+	{
+		for (UInt32 c = 0; c < ConstraintColoring::k_maxColors; ++c)
+		{
+			if ((used & (1ull << c)) == 0)
+			{
+				return c;
+			}
+		}
+		return ConstraintColoring::k_maxColors;
+	}
+
+	void ConstraintColoring::begin(const UInt32 &bodyCount, const UInt32 &count)
+	{
+		m_bodyColors.assign(bodyCount, 0);
+		m_colors.resize(count);
+		m_overflow = false;
+	}
+
+	/*
+	 * Lowest color none of the bodies uses yet, k_maxColors when there is none left
+	 */
+	UInt32 ConstraintColoring::assign(const UInt32 *bodies, const UInt32 &bodyCount)
+	{
+		UInt64 used = 0;
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			used |= bodies[i] != NOT_FOUND ? m_bodyColors[bodies[i]] : 0;
+		}
+
+		const UInt32 color = lowestFreeColor(used);
+		if (color < k_maxColors)
+		{
+			for (UInt32 i = 0; i < bodyCount; ++i)
+			{
+				if (bodies[i] != NOT_FOUND)
+				{
+					m_bodyColors[bodies[i]] |= 1ull << color;
+				}
+			}
+		}
+		else
+		{
+			m_overflow = true;
+		}
+		return color;
+	}
+
+	void ConstraintColoring::build(const UInt32 &bodyCount, const UInt32 &count, const function<pair<UInt32, UInt32>(const UInt32 &)> &bodies)
+	{
+		begin(bodyCount, count);
+
+		UInt32 colorCount = 0;
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			// sleeping bodies still count since joint forces can wake them during the step
+			const auto [a, b] = bodies(i);
+			const UInt32 ends[2] = {a, b};
+			m_colors[i] = assign(ends, 2);
+			colorCount = std::max(colorCount, m_colors[i] + 1);
+		}
+
+		sortByColor(count, colorCount);
+	}
+
+	void ConstraintColoring::build(const UInt32 &bodyCount, const UInt32 &count, const function<UInt32(const UInt32 &, UInt32 *)> &bodies)
+	{
+		begin(bodyCount, count);
+
+		UInt32 colorCount = 0;
+		UInt32 indices[k_maxBodies];
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			const UInt32 used = bodies(i, indices);
+			assert(used <= k_maxBodies);
+			m_colors[i] = assign(indices, used);
+			colorCount = std::max(colorCount, m_colors[i] + 1);
+		}
+
+		sortByColor(count, colorCount);
+	}
+
+	/*
+	 * Counting sort by color, keeping the original order within a color
+	 */
+	void ConstraintColoring::sortByColor(const UInt32 &count, const UInt32 &colorCount)
+	{
+		m_offsets.assign(colorCount + 1, 0);
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			m_offsets[m_colors[i] + 1]++;
+		}
+
+		for (UInt32 c = 0; c < colorCount; ++c)
+		{
+			m_offsets[c + 1] += m_offsets[c];
+		}
+
+		m_constraints.resize(count);
+		vector<UInt32> cursor(m_offsets.begin(), m_offsets.end() - 1);
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			m_constraints[cursor[m_colors[i]]++] = i;
+		}
+	}
+}
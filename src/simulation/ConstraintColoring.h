@@ -0,0 +1,60 @@
+/*
+ * Greedy graph coloring of constraints so that no two constraints of a color share a dynamic body.
+ * Each color can be solved in parallel. Static bodies are never written by the solver so they do not conflict.
+ */
+#ifndef CONSTRAINT_COLORING_H
+#define CONSTRAINT_COLORING_H
+
+#include "math/Math.h"
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+namespace Positional
+{
+	class ConstraintColoring
+	{
+	private:
+		// one bit per color used by each body
+		vector<UInt64> m_bodyColors;
+
+		// members of color i are [offsets[i], offsets[i + 1])
+		vector<UInt32> m_offsets;
+		vector<UInt32> m_constraints;
+		vector<UInt32> m_colors;
+		bool m_overflow;
+
+		void begin(const UInt32 &bodyCount, const UInt32 &count);
+		UInt32 assign(const UInt32 *bodies, const UInt32 &bodyCount);
+		void sortByColor(const UInt32 &count, const UInt32 &colorCount);
+
+	public:
+		// constraints that do not fit in these go to a final color solved serially
+		static const UInt32 k_maxColors = 64;
+		static const UInt32 k_maxBodies = 4;
+
+		ConstraintColoring() : m_overflow(false) {}
+
+		/*
+		 * bodies returns the body store indices of constraint i, NOT_FOUND for static bodies
+		 */
+		void build(const UInt32 &bodyCount, const UInt32 &count, const function<pair<UInt32, UInt32>(const UInt32 &)> &bodies);
+
+		/*
+		 * For constraints on more than two bodies, bodies writes up to k_maxBodies indices of constraint i and returns how many
+		 */
+		void build(const UInt32 &bodyCount, const UInt32 &count, const function<UInt32(const UInt32 &, UInt32 *)> &bodies);
+
+		inline UInt32 count() const { return m_offsets.size() > 0 ? m_offsets.size() - 1 : 0; }
+		inline UInt32 size(const UInt32 &color) const { return m_offsets[color + 1] - m_offsets[color]; }
+		inline UInt32 constraint(const UInt32 &color, const UInt32 &i) const { return m_constraints[m_offsets[color] + i]; }
+		inline const UInt32 *constraints(const UInt32 &color) const { return m_constraints.data() + m_offsets[color]; }
+
+		/*
+		 * Constraints in the last color may share bodies when the graph needed more than k_maxColors
+		 */
+		inline bool isSerial(const UInt32 &color) const { return m_overflow && color == count() - 1; }
+	};
+}
+#endif // CONSTRAINT_COLORING_H
@@ -0,0 +1,146 @@
+#include "Islands.h"
+#include "Body.h"
+
+namespace Positional
+{
+	void Islands::reset(const UInt32 &bodyCount)
+	{
+		m_parent.resize(bodyCount);
+		m_size.resize(bodyCount);
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			m_parent[i] = i;
+			m_size[i] = 1;
+		}
+
+		m_constraintLinks.clear();
+		m_contactLinks.clear();
+	}
+
+	UInt32 Islands::find(UInt32 body)
+	{
+		// path halving
+		while (m_parent[body] != body)
+		{
+			m_parent[body] = m_parent[m_parent[body]];
+			body = m_parent[body];
+		}
+		return body;
+	}
+
+	void Islands::link(const UInt32 &bodyA, const UInt32 &bodyB, const UInt32 &index, vector<pair<UInt32, UInt32>> &links)
+	{
+		const bool validA = bodyA != NOT_FOUND;
+		const bool validB = bodyB != NOT_FOUND;
+		if (!validA && !validB)
+		{
+			return;
+		}
+
+		links.push_back(make_pair(index, validA ? bodyA : bodyB));
+
+		if (validA && validB)
+		{
+			unite(bodyA, bodyB);
+		}
+	}
+
+	void Islands::unite(const UInt32 &bodyA, const UInt32 &bodyB)
+	{
+		// union by size
+		UInt32 rootA = find(bodyA);
+		UInt32 rootB = find(bodyB);
+		if (rootA == rootB)
+		{
+			return;
+		}
+
+		if (m_size[rootA] < m_size[rootB])
+		{
+			std::swap(rootA, rootB);
+		}
+		m_parent[rootB] = rootA;
+		m_size[rootA] += m_size[rootB];
+	}
+
+	void Islands::build()
+	{
+		const UInt32 bodyCount = m_parent.size();
+
+		// number the roots, sizes are no longer needed so reuse their storage
+		vector<UInt32> &rootIsland = m_size;
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			m_parent[i] = find(i);
+		}
+
+		UInt32 islandCount = 0;
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			rootIsland[i] = m_parent[i] == i ? islandCount++ : NOT_FOUND;
+		}
+
+		m_bodyIsland.resize(bodyCount);
+		m_bodyOffsets.assign(islandCount + 1, 0);
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			m_bodyIsland[i] = rootIsland[m_parent[i]];
+			m_bodyOffsets[m_bodyIsland[i] + 1]++;
+		}
+
+		for (UInt32 i = 0; i < islandCount; ++i)
+		{
+			m_bodyOffsets[i + 1] += m_bodyOffsets[i];
+		}
+
+		m_bodies.resize(bodyCount);
+		vector<UInt32> cursor(m_bodyOffsets.begin(), m_bodyOffsets.end() - 1);
+		for (UInt32 i = 0; i < bodyCount; ++i)
+		{
+			m_bodies[cursor[m_bodyIsland[i]]++] = i;
+		}
+
+		bucket(m_constraintLinks, m_constraintOffsets, m_constraints);
+		bucket(m_contactLinks, m_contactOffsets, m_contacts);
+	}
+
+	/*
+	 * Counting sort of links by the island of their body
+	 */
+	void Islands::bucket(const vector<pair<UInt32, UInt32>> &links, vector<UInt32> &outOffsets, vector<UInt32> &outValues) const
+	{
+		const UInt32 islandCount = count();
+		outOffsets.assign(islandCount + 1, 0);
+		for (const auto &[index, body] : links)
+		{
+			outOffsets[m_bodyIsland[body] + 1]++;
+		}
+
+		for (UInt32 i = 0; i < islandCount; ++i)
+		{
+			outOffsets[i + 1] += outOffsets[i];
+		}
+
+		outValues.resize(links.size());
+		vector<UInt32> cursor(outOffsets.begin(), outOffsets.end() - 1);
+		for (const auto &[index, body] : links)
+		{
+			outValues[cursor[m_bodyIsland[body]]++] = index;
+		}
+	}
+
+	IslandStats Islands::stats() const
+	{
+		IslandStats stats = {count(), 0, 0};
+		for (UInt32 i = 0; i < stats.islandCount; ++i)
+		{
+			stats.largestIsland = Math::max(stats.largestIsland, bodyCount(i));
+		}
+
+		if (stats.islandCount > 0)
+		{
+			stats.averageIsland = (Float)m_bodies.size() / stats.islandCount;
+		}
+		return stats;
+	}
+}
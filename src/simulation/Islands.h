@@ -0,0 +1,93 @@
+/*
+ * Simulation islands: groups of bodies connected by colliding contacts or joints.
+ * Built once per step with union-find over body indices, static and kinematic bodies never connect islands.
+ */
+#ifndef ISLANDS_H
+#define ISLANDS_H
+
+#include "math/Math.h"
+#include "data/Store.h"
+#include <vector>
+
+using namespace std;
+
+namespace Positional
+{
+	struct Body;
+
+	struct IslandStats
+	{
+		UInt32 islandCount;
+		UInt32 largestIsland;
+		Float averageIsland;
+	};
+
+	class Islands
+	{
+	private:
+		// union-find
+		vector<UInt32> m_parent;
+		vector<UInt32> m_size;
+
+		// constraint or contact index and one of its dynamic bodies
+		vector<pair<UInt32, UInt32>> m_constraintLinks;
+		vector<pair<UInt32, UInt32>> m_contactLinks;
+
+		// island of each body
+		vector<UInt32> m_bodyIsland;
+
+		// members of island i are [offsets[i], offsets[i + 1])
+		vector<UInt32> m_bodyOffsets;
+		vector<UInt32> m_bodies;
+		vector<UInt32> m_constraintOffsets;
+		vector<UInt32> m_constraints;
+		vector<UInt32> m_contactOffsets;
+		vector<UInt32> m_contacts;
+
+		UInt32 find(UInt32 body);
+		void unite(const UInt32 &bodyA, const UInt32 &bodyB);
+		void link(const UInt32 &bodyA, const UInt32 &bodyB, const UInt32 &index, vector<pair<UInt32, UInt32>> &links);
+		void bucket(const vector<pair<UInt32, UInt32>> &links, vector<UInt32> &outOffsets, vector<UInt32> &outValues) const;
+
+	public:
+		/*
+		 * Starts a new build with every body in its own island
+		 */
+		void reset(const UInt32 &bodyCount);
+
+		// body store indices, NOT_FOUND for static
+		void addConstraint(const UInt32 &index, const UInt32 &a, const UInt32 &b) { link(a, b, index, m_constraintLinks); }
+		void addContact(const UInt32 &index, const UInt32 &a, const UInt32 &b) { link(a, b, index, m_contactLinks); }
+
+		/*
+		 * Joins the islands of two bodies without a constraint or contact to list, as for the links of an articulation
+		 */
+		void connect(const Ref<Body> &a, const Ref<Body> &b)
+		{
+			if (a.valid() && b.valid())
+			{
+				unite(a.index(), b.index());
+			}
+		}
+
+		/*
+		 * Assigns island ids and groups bodies, constraints and contacts by island
+		 */
+		void build();
+
+		inline UInt32 count() const { return m_bodyOffsets.size() > 0 ? m_bodyOffsets.size() - 1 : 0; }
+		inline UInt32 islandOf(const UInt32 &body) const { return m_bodyIsland[body]; }
+
+		inline UInt32 bodyCount(const UInt32 &island) const { return m_bodyOffsets[island + 1] - m_bodyOffsets[island]; }
+		inline UInt32 body(const UInt32 &island, const UInt32 &i) const { return m_bodies[m_bodyOffsets[island] + i]; }
+
+		inline UInt32 constraintCount(const UInt32 &island) const { return m_constraintOffsets[island + 1] - m_constraintOffsets[island]; }
+		inline UInt32 constraint(const UInt32 &island, const UInt32 &i) const { return m_constraints[m_constraintOffsets[island] + i]; }
+
+		inline UInt32 contactCount(const UInt32 &island) const { return m_contactOffsets[island + 1] - m_contactOffsets[island]; }
+		inline UInt32 contact(const UInt32 &island, const UInt32 &i) const { return m_contacts[m_contactOffsets[island] + i]; }
+
+		IslandStats stats() const;
+	};
+}
+#endif // ISLANDS_H
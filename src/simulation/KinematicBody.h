@@ -0,0 +1,50 @@
+#ifndef KINEMATICBODY_H
+#define KINEMATICBODY_H
+
+#include "Body.h"
+
+namespace Positional
+{
+	/*
+	 * Moved by its velocity or Body::moveTo alone, gravity, forces and constraints leave it be
+	 */
+	struct KinematicBody final
+	{
+		static void integrate(Body *const *bodies, const UInt32 &count, const Float &dt, const Vec3 &gravity)
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				Body &body = *bodies[i];
+				body.prePose = body.pose;
+				body.pose.position += dt * body.velocity.linear;
+
+				// exact rotation about the origin, so substeps add up to the target
+				const Float speed = body.velocity.angular.length();
+				if (speed > 0)
+				{
+					body.pose.rotation = (Quat::fromAngleAxis(speed * dt, body.velocity.angular / speed) * body.pose.rotation).normalized();
+				}
+
+				body.forces.linear = Vec3::zero;
+				body.forces.angular = Vec3::zero;
+				body.poseChanged();
+			}
+		}
+
+		// the velocity is given, not measured
+		static void differentiate(Body *const *bodies, const UInt32 &count, const Float &dtInv)
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				bodies[i]->preVelocity = bodies[i]->velocity;
+			}
+		}
+
+		static bool hasRotation() { return true; }
+		static bool isKinematic() { return true; }
+
+	private:
+		KinematicBody() {}
+	};
+}
+#endif // KINEMATICBODY_H
\ No newline at end of file
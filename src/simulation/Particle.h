@@ -8,19 +8,46 @@ namespace Positional
 {
 	struct Particle final
 	{
-		static void integrate(Body &body, const Float &dt, const Vec3 &gravity)
+		/*
+		 * Kernels over awake particles, forces are only applied when set and cleared in the same pass
+		 */
+		static void integrate(Body *const *bodies, const UInt32 &count, const Float &dt, const Vec3 &gravity)
 		{
-			// TODO: apply all external forces
-			body.velocity.linear = body.velocity.linear + dt * gravity + dt * body.invMass * body.forces.linear;
-			body.pose.position = body.pose.position + dt * body.velocity.linear;
+			const Vec3 dv = dt * gravity;
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				Body &body = *bodies[i];
+				body.prePose = body.pose;
+
+				// TODO: apply all external forces
+				if (body.forces.linear != Vec3::zero)
+				{
+					body.velocity.linear = body.velocity.linear + dv + dt * body.invMass * body.forces.linear;
+					body.forces.linear = Vec3::zero;
+				}
+				else
+				{
+					body.velocity.linear = body.velocity.linear + dv;
+				}
+				body.forces.angular = Vec3::zero;
+
+				body.pose.position = body.pose.position + dt * body.velocity.linear;
+				body.poseChanged();
+			}
 		}
 
-		static void differentiate(Body &body, const Float &dtInv)
+		static void differentiate(Body *const *bodies, const UInt32 &count, const Float &dtInv)
 		{
-			body.velocity.linear = (body.pose.position - body.prePose.position) * dtInv;
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				Body &body = *bodies[i];
+				body.preVelocity = body.velocity;
+				body.velocity.linear = (body.pose.position - body.prePose.position) * dtInv;
+			}
 		}
 
 		static bool hasRotation() { return false; }
+		static bool isKinematic() { return false; }
 
 	private:
 		Particle() {}
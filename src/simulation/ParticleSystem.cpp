@@ -0,0 +1,1223 @@
+#include "ParticleSystem.h"
+#include "collision/collider/SphereCollider.h"
+#include <algorithm>
+
+namespace Positional
+{
+	const UInt32 ParticleSystem::k_batch;
+	const UInt32 ParticleSystem::k_staticBatch;
+	const UInt32 ParticleSystem::k_maxNeighbourRanges;
+
+	// fraction of the smoothing radius fluid neighbours are searched beyond it, so lists hold for the whole step
+	const Float k_neighbourSkin = 0.25;
+
+	ParticleSystem::ParticleSystem(const bool &fluid) :
+		m_count(0),
+		m_maxRadius(0),
+		m_bucketMask(0),
+		m_colorsDirty(false),
+		m_fluid(fluid),
+		m_kernelRadius(0),
+		m_restDensity(0),
+		m_restGradient(0),
+		m_sphere(Collider::create<SphereCollider>(Body::null, Vec3(0, 0, 0), Quat(), Shape((Float)0), 1, 0, 0, 0)),
+		selfCollision(true),
+		mask(0xFFFFFFFFui32),
+		pushBodies(true),
+		smoothingRadius(0),
+		relaxation(0.01),
+		viscosity(0.01),
+		vorticity(0)
+	{
+	}
+
+#pragma region Particles
+
+	UInt32 ParticleSystem::add(const Vec3 &position, const Float &radius, const Float &mass, const Vec3 &velocity)
+	{
+		assert(radius > 0);
+
+		// grow by whole lanes, new padding is zero so it neither moves nor collides
+		if (m_count == m_x.size())
+		{
+			const UInt32 size = m_count + Wide::width;
+			for (FloatLanes *column : {&m_x, &m_y, &m_z, &m_vx, &m_vy, &m_vz, &m_px, &m_py, &m_pz, &m_dx, &m_dy, &m_dz, &m_invMass})
+			{
+				column->resize(size, 0);
+			}
+			m_radius.resize(size, 0);
+		}
+
+		const UInt32 i = m_count++;
+		setPosition(i, position);
+		setVelocity(i, velocity);
+		m_px[i] = position.x; m_py[i] = position.y; m_pz[i] = position.z;
+		m_invMass[i] = mass > 0 ? 1 / mass : 0;
+		m_radius[i] = radius;
+		m_maxRadius = Math::max(m_maxRadius, radius);
+		return i;
+	}
+
+	void ParticleSystem::clear()
+	{
+		for (FloatLanes *column : {&m_x, &m_y, &m_z, &m_vx, &m_vy, &m_vz, &m_px, &m_py, &m_pz, &m_dx, &m_dy, &m_dz, &m_invMass})
+		{
+			column->clear();
+		}
+		m_radius.clear();
+		m_count = 0;
+		m_maxRadius = 0;
+		clearConstraints();
+	}
+
+#pragma endregion Particles
+
+#pragma region Constraints
+
+	UInt32 ParticleSystem::addDistance(const UInt32 &a, const UInt32 &b, const Float &compliance)
+	{
+		assert(a < m_count && b < m_count && a != b);
+		m_distances.push_back(DistanceConstraint{a, b, (position(a) - position(b)).length(), compliance});
+		m_colorsDirty = true;
+		return m_distances.size() - 1;
+	}
+
+	UInt32 ParticleSystem::addBending(const UInt32 &a, const UInt32 &b, const UInt32 &c, const Float &compliance)
+	{
+		assert(a < m_count && b < m_count && c < m_count);
+		const Vec3 centroid = (position(a) + position(b) + position(c)) * (1.0 / 3.0);
+		m_bendings.push_back(BendingConstraint{a, b, c, (position(b) - centroid).length(), compliance});
+		m_colorsDirty = true;
+		return m_bendings.size() - 1;
+	}
+
+	UInt32 ParticleSystem::addVolume(const UInt32 &a, const UInt32 &b, const UInt32 &c, const UInt32 &d, const Float &compliance)
+	{
+		assert(a < m_count && b < m_count && c < m_count && d < m_count);
+		const Vec3 origin = position(a);
+		const Float volume = (position(b) - origin).dot((position(c) - origin).cross(position(d) - origin));
+		m_volumes.push_back(VolumeConstraint{a, b, c, d, volume, compliance});
+		m_colorsDirty = true;
+		return m_volumes.size() - 1;
+	}
+
+	UInt32 ParticleSystem::attach(const UInt32 &particle, const Ref<Body> &body, const Float &compliance)
+	{
+		assert(particle < m_count);
+		const Vec3 point = body.valid() ? body.get().pose.inverseTransform(position(particle)) : position(particle);
+		m_attachments.push_back(Attachment{particle, body, body.valid(), point, compliance, &Body::immovable});
+		return m_attachments.size() - 1;
+	}
+
+	void ParticleSystem::clearConstraints()
+	{
+		m_distances.clear();
+		m_bendings.clear();
+		m_volumes.clear();
+		m_attachments.clear();
+		m_sleepingContacts.clear();
+		m_colorsDirty = true;
+	}
+
+	/*
+	 * Particles without mass are never written, so they do not keep constraints apart
+	 */
+	void ParticleSystem::colorConstraints()
+	{
+		const auto particle = [this](const UInt32 &i)
+		{
+			return m_invMass[i] > 0 ? i : NOT_FOUND;
+		};
+
+		m_distanceColors.build(m_count, m_distances.size(), [&, this](const UInt32 &i, UInt32 *outParticles)
+		{
+			const DistanceConstraint &constraint = m_distances[i];
+			outParticles[0] = particle(constraint.a);
+			outParticles[1] = particle(constraint.b);
+			return 2u;
+		});
+
+		m_bendingColors.build(m_count, m_bendings.size(), [&, this](const UInt32 &i, UInt32 *outParticles)
+		{
+			const BendingConstraint &constraint = m_bendings[i];
+			outParticles[0] = particle(constraint.a);
+			outParticles[1] = particle(constraint.b);
+			outParticles[2] = particle(constraint.c);
+			return 3u;
+		});
+
+		m_volumeColors.build(m_count, m_volumes.size(), [&, this](const UInt32 &i, UInt32 *outParticles)
+		{
+			const VolumeConstraint &constraint = m_volumes[i];
+			outParticles[0] = particle(constraint.a);
+			outParticles[1] = particle(constraint.b);
+			outParticles[2] = particle(constraint.c);
+			outParticles[3] = particle(constraint.d);
+			return 4u;
+		});
+
+		m_colorsDirty = false;
+	}
+
+	void ParticleSystem::solveColored(const ConstraintColoring &coloring, ITaskScheduler &scheduler, const function<void(const UInt32 &)> &solve)
+	{
+		for (UInt32 c = 0, colorCount = coloring.count(); c < colorCount; ++c)
+		{
+			const UInt32 size = coloring.size(c);
+			const UInt32 *constraints = coloring.constraints(c);
+			if (coloring.isSerial(c) || size < k_batch)
+			{
+				for (UInt32 i = 0; i < size; ++i)
+				{
+					solve(constraints[i]);
+				}
+				continue;
+			}
+
+			scheduler.parallelFor(size, k_batch, [&](const UInt32 &begin, const UInt32 &end)
+			{
+				for (UInt32 i = begin; i < end; ++i)
+				{
+					solve(constraints[i]);
+				}
+			});
+		}
+	}
+
+	/*
+	 * Colors in parallel, attachments one after another since they may share a body
+	 */
+	void ParticleSystem::solveConstraints(const Float &dtInvSq, ITaskScheduler &scheduler)
+	{
+		solveColored(m_distanceColors, scheduler, [&, this](const UInt32 &i)
+		{
+			solveDistance(m_distances[i], dtInvSq);
+		});
+
+		solveColored(m_bendingColors, scheduler, [&, this](const UInt32 &i)
+		{
+			solveBending(m_bendings[i], dtInvSq);
+		});
+
+		solveColored(m_volumeColors, scheduler, [&, this](const UInt32 &i)
+		{
+			solveVolume(m_volumes[i], dtInvSq);
+		});
+
+		for (const Attachment &attachment : m_attachments)
+		{
+			solveAttachment(attachment, dtInvSq);
+		}
+	}
+
+	void ParticleSystem::solveDistance(const DistanceConstraint &constraint, const Float &dtInvSq)
+	{
+		const Float wa = m_invMass[constraint.a];
+		const Float wb = m_invMass[constraint.b];
+		const Vec3 delta = position(constraint.a) - position(constraint.b);
+		const Float length = delta.length();
+		if (wa + wb == 0 || length < Math::Epsilon)
+		{
+			return;
+		}
+
+		// particles without mass are shared between constraints of one color, so they are never written
+		const Vec3 normal = delta * (1.0 / length);
+		const Float lambda = -(length - constraint.restLength) / (wa + wb + constraint.compliance * dtInvSq);
+		if (wa > 0)
+		{
+			setPosition(constraint.a, position(constraint.a) + normal * (lambda * wa));
+		}
+		if (wb > 0)
+		{
+			setPosition(constraint.b, position(constraint.b) - normal * (lambda * wb));
+		}
+	}
+
+	/*
+	 * Gradients are 2/3 of the normal for b and -1/3 for a and c
+	 */
+	void ParticleSystem::solveBending(const BendingConstraint &constraint, const Float &dtInvSq)
+	{
+		const Float wa = m_invMass[constraint.a];
+		const Float wb = m_invMass[constraint.b];
+		const Float wc = m_invMass[constraint.c];
+		const Vec3 a = position(constraint.a);
+		const Vec3 b = position(constraint.b);
+		const Vec3 c = position(constraint.c);
+		const Vec3 delta = b - (a + b + c) * (1.0 / 3.0);
+		const Float length = delta.length();
+		const Float w = (wa + 4 * wb + wc) * (1.0 / 9.0);
+		if (w == 0 || length < Math::Epsilon)
+		{
+			return;
+		}
+
+		const Vec3 normal = delta * (1.0 / length);
+		const Float lambda = -(length - constraint.restDistance) / (w + constraint.compliance * dtInvSq);
+		if (wa > 0)
+		{
+			setPosition(constraint.a, a - normal * (lambda * wa * (1.0 / 3.0)));
+		}
+		if (wb > 0)
+		{
+			setPosition(constraint.b, b + normal * (lambda * wb * (2.0 / 3.0)));
+		}
+		if (wc > 0)
+		{
+			setPosition(constraint.c, c - normal * (lambda * wc * (1.0 / 3.0)));
+		}
+	}
+
+	void ParticleSystem::solveVolume(const VolumeConstraint &constraint, const Float &dtInvSq)
+	{
+		const UInt32 indices[4] = {constraint.a, constraint.b, constraint.c, constraint.d};
+		const Vec3 origin = position(constraint.a);
+		const Vec3 e1 = position(constraint.b) - origin;
+		const Vec3 e2 = position(constraint.c) - origin;
+		const Vec3 e3 = position(constraint.d) - origin;
+
+		Vec3 gradients[4];
+		gradients[1] = e2.cross(e3);
+		gradients[2] = e3.cross(e1);
+		gradients[3] = e1.cross(e2);
+		gradients[0] = -(gradients[1] + gradients[2] + gradients[3]);
+
+		Float w = 0;
+		for (UInt32 k = 0; k < 4; ++k)
+		{
+			w += m_invMass[indices[k]] * gradients[k].lengthSq();
+		}
+
+		if (w == 0)
+		{
+			return;
+		}
+
+		const Float lambda = -(e1.dot(gradients[1]) - constraint.restVolume) / (w + constraint.compliance * dtInvSq);
+		for (UInt32 k = 0; k < 4; ++k)
+		{
+			if (m_invMass[indices[k]] > 0)
+			{
+				setPosition(indices[k], position(indices[k]) + gradients[k] * (lambda * m_invMass[indices[k]]));
+			}
+		}
+	}
+
+	void ParticleSystem::solveAttachment(const Attachment &attachment, const Float &dtInvSq)
+	{
+		Body &body = *attachment.resolved;
+		const UInt32 i = attachment.particle;
+		const Vec3 target = body.pose.transform(attachment.point);
+		const Vec3 delta = position(i) - target;
+		const Float length = delta.length();
+		if (length < Math::Epsilon)
+		{
+			return;
+		}
+
+		const Vec3 normal = delta * (1.0 / length);
+		const Float wp = m_invMass[i];
+		const Float wb = body.getInverseMass(normal, target);
+		if (wp + wb == 0)
+		{
+			return;
+		}
+
+		const Float lambda = length / (wp + wb + attachment.compliance * dtInvSq);
+		setPosition(i, position(i) - normal * (lambda * wp));
+		if (wb > 0)
+		{
+			body.applyCorrection(normal * lambda, target);
+		}
+	}
+
+#pragma endregion Constraints
+
+#pragma region Step
+
+	void ParticleSystem::beginStep(const Float &deltaTime, const Vec3 &gravity, ITaskScheduler &scheduler, const Collision::IBroadphase &broadphase, const Collision::INarrowphase &narrowphase, Store<Body> &bodies)
+	{
+		if (m_count == 0)
+		{
+			return;
+		}
+
+		if (m_colorsDirty)
+		{
+			colorConstraints();
+		}
+
+		// a point in the space of a destroyed body means nothing anymore
+		m_attachments.erase(remove_if(m_attachments.begin(), m_attachments.end(), [](const Attachment &attachment)
+		{
+			return attachment.onBody && !attachment.body.valid();
+		}), m_attachments.end());
+
+		for (Attachment &attachment : m_attachments)
+		{
+			attachment.resolved = attachment.onBody ? &bodies[attachment.body.index()] : &Body::immovable;
+		}
+		m_sleepingContacts.clear();
+
+		if (m_fluid)
+		{
+			updateKernel();
+			findNeighbours(scheduler);
+			m_staticOrder = m_neighbourOrder;
+		}
+		else
+		{
+			buildHash(2 * m_maxRadius, scheduler);
+			m_staticOrder.swap(m_sorted);
+		}
+		findColliders(deltaTime, gravity, scheduler, broadphase, narrowphase, bodies);
+	}
+
+	/*
+	 * Particles closer than cellSize are at most one cell apart
+	 */
+	void ParticleSystem::buildHash(const Float &cellSize, ITaskScheduler &scheduler)
+	{
+		UInt32 bucketCount = 1;
+		while (bucketCount < 2 * m_count)
+		{
+			bucketCount <<= 1;
+		}
+		m_bucketMask = bucketCount - 1;
+
+		const Float cellInv = 1 / cellSize;
+		m_cells.resize(3 * m_count);
+		m_bucket.resize(m_count);
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				Int32 *cell = &m_cells[3 * i];
+				cell[0] = (Int32)Math::floor(m_x[i] * cellInv);
+				cell[1] = (Int32)Math::floor(m_y[i] * cellInv);
+				cell[2] = (Int32)Math::floor(m_z[i] * cellInv);
+				m_bucket[i] = bucketOf(cell[0], cell[1], cell[2]);
+			}
+		});
+
+		// counting sort, filled back to front so each bucket keeps index order for any thread count
+		m_bucketStart.assign(bucketCount + 1, 0);
+		for (UInt32 i = 0; i < m_count; ++i)
+		{
+			m_bucketStart[m_bucket[i]]++;
+		}
+		for (UInt32 b = 1; b < bucketCount; ++b)
+		{
+			m_bucketStart[b] += m_bucketStart[b - 1];
+		}
+		m_bucketStart[bucketCount] = m_count;
+
+		m_sorted.resize(m_count);
+		for (UInt32 i = m_count; i-- > 0;)
+		{
+			m_sorted[--m_bucketStart[m_bucket[i]]] = i;
+		}
+	}
+
+	void ParticleSystem::gatherHashed(const vector<UInt32> &order, ITaskScheduler &scheduler)
+	{
+		m_hashed.resize(m_count);
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				const UInt32 i = order[k];
+				m_hashed[k] = HashedParticle{m_x[i], m_y[i], m_z[i], m_radius[i], m_invMass[i]};
+			}
+		});
+	}
+
+	/*
+	 * Hashed order keeps neighbours together, so one query of each tree serves a batch of particles.
+	 * Static colliders are kept for the batch, colliders of bodies for each particle whose reach they are in.
+	 */
+	void ParticleSystem::findColliders(const Float &deltaTime, const Vec3 &gravity, ITaskScheduler &scheduler, const Collision::IBroadphase &broadphase, const Collision::INarrowphase &narrowphase, Store<Body> &bodies)
+	{
+		const UInt32 batchCount = (m_count + k_staticBatch - 1) / k_staticBatch;
+		if (m_batchStatics.size() < batchCount)
+		{
+			m_batchStatics.resize(batchCount);
+			m_batchBodies.resize(batchCount);
+		}
+
+		const Float gravitySpeed = gravity.length() * deltaTime;
+		const auto reach = [&, this](const UInt32 &i)
+		{
+			return Bounds(position(i), Vec3(m_radius[i] + (velocity(i).length() + gravitySpeed) * deltaTime));
+		};
+
+		scheduler.parallelFor(batchCount, k_batch / k_staticBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 b = begin; b < end; ++b)
+			{
+				vector<StaticCandidate> &statics = m_batchStatics[b];
+				vector<BodyCandidate> &candidates = m_batchBodies[b];
+				statics.clear();
+				candidates.clear();
+
+				const UInt32 first = b * k_staticBatch;
+				const UInt32 last = std::min(first + k_staticBatch, m_count);
+				Bounds bounds;
+				bool empty = true;
+				for (UInt32 k = first; k < last; ++k)
+				{
+					const UInt32 i = m_staticOrder[k];
+					if (m_invMass[i] == 0)
+					{
+						continue;
+					}
+
+					const Bounds swept = reach(i);
+					bounds = empty ? swept : bounds.merged(swept);
+					empty = false;
+				}
+
+				if (empty)
+				{
+					continue;
+				}
+
+				broadphase.intersectsStatic(bounds, mask, [&](const Ref<Collider> &ref)
+				{
+					const Collider &collider = ref.get();
+					statics.push_back(StaticCandidate{&collider, collider.bounds(), narrowphase.getComputeFunction(m_sphere, collider)});
+				});
+
+				broadphase.intersectsDynamic(bounds, mask, [&](const Ref<Collider> &ref)
+				{
+					const Collider &collider = ref.get();
+					Body &body = bodies[collider.body().index()];
+
+					// padded by how far the collider may move, the rotation only roughly
+					Bounds colliderBounds = collider.bounds();
+					colliderBounds.expand((body.velocity.linear.length() + body.velocity.angular.length() * colliderBounds.extents().length()) * deltaTime);
+
+					const Collision::PenetrationFunction compute = narrowphase.getComputeFunction(m_sphere, collider);
+					for (UInt32 k = first; k < last; ++k)
+					{
+						const UInt32 i = m_staticOrder[k];
+						if (m_invMass[i] > 0 && reach(i).intersects(colliderBounds))
+						{
+							candidates.push_back(BodyCandidate{i, &collider, &body, compute});
+						}
+					}
+				});
+			}
+		});
+	}
+
+	inline void integrateAxis(Float *position, Float *velocity, Float *previous, const Wide &moving, const Wide &dv, const Wide &dt)
+	{
+		const Wide x = Wide::load(position);
+		const Wide v = Wide::load(velocity);
+		const Wide vNext = Wide::select(moving, v + dv, v);
+		x.store(previous);
+		(x + vNext * dt).store(position);
+		vNext.store(velocity);
+	}
+
+	inline void differentiateAxis(const Float *position, Float *velocity, const Float *previous, const Wide &moving, const Wide &dtInv)
+	{
+		const Wide v = Wide::load(velocity);
+		Wide::select(moving, (Wide::load(position) - Wide::load(previous)) * dtInv, v).store(velocity);
+	}
+
+	inline void correctAxis(Float *position, const Float *correction)
+	{
+		(Wide::load(position) + Wide::load(correction)).store(position);
+	}
+
+	void ParticleSystem::integrate(const Float &dt, const Vec3 &gravity, ITaskScheduler &scheduler)
+	{
+		scheduler.parallelFor(m_x.size() / Wide::width, k_batch / Wide::width, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			const Wide zero(0.0);
+			const Wide h(dt);
+			const Wide gx(gravity.x * dt), gy(gravity.y * dt), gz(gravity.z * dt);
+			for (UInt32 i = begin * Wide::width, last = end * Wide::width; i < last; i += Wide::width)
+			{
+				const Wide moving = Wide::load(&m_invMass[i]) > zero;
+				integrateAxis(&m_x[i], &m_vx[i], &m_px[i], moving, gx, h);
+				integrateAxis(&m_y[i], &m_vy[i], &m_py[i], moving, gy, h);
+				integrateAxis(&m_z[i], &m_vz[i], &m_pz[i], moving, gz, h);
+			}
+		});
+	}
+
+	void ParticleSystem::solvePositions(const Float &dtInvSq, ITaskScheduler &scheduler)
+	{
+		if (m_count == 0)
+		{
+			return;
+		}
+
+		solveConstraints(dtInvSq, scheduler);
+
+		if (m_fluid || selfCollision)
+		{
+			if (m_fluid)
+			{
+				solveDensity(scheduler);
+			}
+			else
+			{
+				collideParticles(scheduler);
+			}
+			scheduler.parallelFor(m_x.size() / Wide::width, k_batch / Wide::width, [&, this](const UInt32 &begin, const UInt32 &end)
+			{
+				for (UInt32 i = begin * Wide::width, last = end * Wide::width; i < last; i += Wide::width)
+				{
+					correctAxis(&m_x[i], &m_dx[i]);
+					correctAxis(&m_y[i], &m_dy[i]);
+					correctAxis(&m_z[i], &m_dz[i]);
+				}
+			});
+		}
+
+		// last, so particles pushed by their neighbours do not end up inside colliders
+		collideBodies();
+		collideStatics(scheduler);
+	}
+
+	void ParticleSystem::differentiate(const Float &dtInv, ITaskScheduler &scheduler)
+	{
+		scheduler.parallelFor(m_x.size() / Wide::width, k_batch / Wide::width, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			const Wide zero(0.0);
+			const Wide hInv(dtInv);
+			for (UInt32 i = begin * Wide::width, last = end * Wide::width; i < last; i += Wide::width)
+			{
+				const Wide moving = Wide::load(&m_invMass[i]) > zero;
+				differentiateAxis(&m_x[i], &m_vx[i], &m_px[i], moving, hInv);
+				differentiateAxis(&m_y[i], &m_vy[i], &m_py[i], moving, hInv);
+				differentiateAxis(&m_z[i], &m_vz[i], &m_pz[i], moving, hInv);
+			}
+		});
+	}
+
+	/*
+	 * Ranges of m_sorted in the 27 cells around the particle. A column of three cells is three consecutive
+	 * buckets read as one range, only columns that hash into each other or wrap around the table go bucket by bucket.
+	 */
+	UInt32 ParticleSystem::neighbourRanges(const UInt32 &i, UInt32 *outRanges) const
+	{
+		const Int32 *cell = &m_cells[3 * i];
+		const UInt32 bucketMask = m_bucketMask;
+		UInt32 columns[9];
+		UInt32 rangeCount = 0;
+
+		const auto addRange = [&](const UInt32 &begin, const UInt32 &end)
+		{
+			if (begin == end)
+			{
+				return;
+			}
+
+			if (rangeCount > 0 && outRanges[2 * rangeCount - 1] == begin)
+			{
+				outRanges[2 * rangeCount - 1] = end;
+				return;
+			}
+			outRanges[2 * rangeCount] = begin;
+			outRanges[2 * rangeCount + 1] = end;
+			rangeCount++;
+		};
+
+		for (UInt32 c = 0; c < 9; ++c)
+		{
+			const UInt32 first = bucketOf(cell[0] + (Int32)(c / 3) - 1, cell[1] + (Int32)(c % 3) - 1, cell[2] - 1);
+			columns[c] = first;
+
+			bool clash = first + 3 > bucketMask + 1;
+			for (UInt32 d = 0; d < c; ++d)
+			{
+				clash |= ((first - columns[d] + 2) & bucketMask) < 5;
+			}
+
+			if (!clash)
+			{
+				addRange(m_bucketStart[first], m_bucketStart[first + 3]);
+				continue;
+			}
+
+			for (UInt32 cz = 0; cz < 3; ++cz)
+			{
+				const UInt32 bucket = (first + cz) & bucketMask;
+				bool visited = false;
+				for (UInt32 d = 0; d < c; ++d)
+				{
+					visited |= ((bucket - columns[d]) & bucketMask) < 3;
+				}
+
+				if (!visited)
+				{
+					addRange(m_bucketStart[bucket], m_bucketStart[bucket + 1]);
+				}
+			}
+		}
+		return rangeCount;
+	}
+
+	/*
+	 * Jacobi: every particle sums its own push out of all overlapping neighbours from unchanged positions and
+	 * averages it, so particles solve in parallel without sharing writes. Runs in hashed order on copies of
+	 * the positions, which keeps the neighbour reads local.
+	 */
+	void ParticleSystem::collideParticles(ITaskScheduler &scheduler)
+	{
+		// cells one particle diameter wide, so overlapping particles are at most one cell apart
+		buildHash(2 * m_maxRadius, scheduler);
+		gatherHashed(m_sorted, scheduler);
+
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			UInt32 ranges[2 * k_maxNeighbourRanges];
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				const HashedParticle &p = m_hashed[k];
+				const UInt32 i = m_sorted[k];
+				Vec3 correction = Vec3::zero;
+				UInt32 overlaps = 0;
+				for (UInt32 r = 0, rangeCount = p.invMass > 0 ? neighbourRanges(i, ranges) : 0; r < rangeCount; ++r)
+				{
+					for (UInt32 n = ranges[2 * r], last = ranges[2 * r + 1]; n < last; ++n)
+					{
+						const HashedParticle &q = m_hashed[n];
+						const Vec3 delta(p.x - q.x, p.y - q.y, p.z - q.z);
+						const Float radius = p.radius + q.radius;
+						const Float distSq = delta.lengthSq();
+						if (distSq >= radius * radius || n == k || distSq < Math::Epsilon)
+						{
+							continue;
+						}
+
+						const Float dist = Math::sqrt(distSq);
+						correction += delta * ((radius - dist) / dist * p.invMass / (p.invMass + q.invMass));
+						overlaps++;
+					}
+				}
+
+				if (overlaps > 1)
+				{
+					correction = correction * (1.0 / overlaps);
+				}
+				m_dx[i] = correction.x;
+				m_dy[i] = correction.y;
+				m_dz[i] = correction.z;
+			}
+		});
+	}
+
+	/*
+	 * Pushes particles out of the static candidates of their batch and applies position level friction
+	 * against their motion in this substep, like ContactConstraint does for bodies.
+	 */
+	void ParticleSystem::collideStatics(ITaskScheduler &scheduler)
+	{
+		const UInt32 batchCount = (m_count + k_staticBatch - 1) / k_staticBatch;
+		scheduler.parallelFor(batchCount, k_batch / k_staticBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			Collider sphere = m_sphere;
+			ContactPoint contact;
+			for (UInt32 b = begin; b < end; ++b)
+			{
+				const vector<StaticCandidate> &statics = m_batchStatics[b];
+				if (statics.empty())
+				{
+					continue;
+				}
+
+				for (UInt32 k = b * k_staticBatch, last = std::min(k + k_staticBatch, m_count); k < last; ++k)
+				{
+					const UInt32 i = m_staticOrder[k];
+					if (m_invMass[i] == 0)
+					{
+						continue;
+					}
+
+					sphere.shape.radius = m_radius[i];
+					for (const StaticCandidate &candidate : statics)
+					{
+						const Vec3 p = position(i);
+						if (!Bounds(p, Vec3(m_radius[i])).intersects(candidate.bounds))
+						{
+							continue;
+						}
+
+						sphere.pose.position = p;
+						if (!candidate.compute(sphere, *candidate.collider, contact))
+						{
+							continue;
+						}
+
+						// the normal points from the collider to the particle
+						Vec3 corrected = p + contact.normal * contact.depth;
+						const Vec3 moved = corrected - Vec3(m_px[i], m_py[i], m_pz[i]);
+						const Vec3 tangent = moved - contact.normal * moved.dot(contact.normal);
+						const Float tangentLength = tangent.length();
+						if (tangentLength <= candidate.collider->staticFriction * contact.depth)
+						{
+							corrected -= tangent;
+						}
+						else if (tangentLength > 0)
+						{
+							corrected -= tangent * Math::min(candidate.collider->dynamicFriction * contact.depth / tangentLength, 1);
+						}
+						setPosition(i, corrected);
+					}
+				}
+			}
+		});
+	}
+
+	/*
+	 * Like collideStatics with the body taking its share of the push and friction, so body mass decides who moves.
+	 * One particle after another in hashed order, many particles touch the same body.
+	 */
+	void ParticleSystem::collideBodies()
+	{
+		Collider sphere = m_sphere;
+		ContactPoint contact;
+		for (UInt32 b = 0, batchCount = (m_count + k_staticBatch - 1) / k_staticBatch; b < batchCount; ++b)
+		{
+			for (const BodyCandidate &candidate : m_batchBodies[b])
+			{
+				const UInt32 i = candidate.particle;
+				Vec3 p = position(i);
+				sphere.shape.radius = m_radius[i];
+				sphere.pose.position = p;
+				if (!candidate.compute(sphere, *candidate.collider, contact))
+				{
+					continue;
+				}
+
+				// the normal points from the collider to the particle, sleeping bodies have no inverse mass
+				Body &body = *candidate.body;
+				if (body.isSleeping())
+				{
+					m_sleepingContacts.push_back(SleepingContact{&body, velocity(i).lengthSq()});
+				}
+				const Vec3 &normal = contact.normal;
+				const Float wp = m_invMass[i];
+				Vec3 point = body.pose.transform(contact.pointB);
+				const Float wb = pushBodies ? body.getInverseMass(normal, point) : 0;
+				const Float lambda = contact.depth / (wp + wb);
+				p += normal * (lambda * wp);
+				if (wb > 0)
+				{
+					body.applyCorrection(-normal * lambda, point);
+				}
+
+				// friction against the motion relative to the body in this substep
+				point = body.pose.transform(contact.pointB);
+				const Vec3 moved = (p - Vec3(m_px[i], m_py[i], m_pz[i])) - (point - body.prePose.transform(contact.pointB));
+				const Vec3 tangent = moved - normal * moved.dot(normal);
+				const Float tangentLength = tangent.length();
+				if (tangentLength > 0)
+				{
+					const Vec3 normalT = tangent * (1.0 / tangentLength);
+					const Float wbT = pushBodies ? body.getInverseMass(normalT, point) : 0;
+					const Float lambdaT = tangentLength / (wp + wbT);
+					const Float scale = lambdaT <= candidate.collider->staticFriction * lambda ? 1 : Math::min(candidate.collider->dynamicFriction * lambda / lambdaT, 1);
+					p -= normalT * (lambdaT * scale * wp);
+					if (wbT > 0)
+					{
+						body.applyCorrection(normalT * (lambdaT * scale), point);
+					}
+				}
+				setPosition(i, p);
+			}
+		}
+	}
+
+	/*
+	 * Like a moving body in the island of a sleeping one, a particle that ran into a body faster than speed wakes it
+	 */
+	void ParticleSystem::wakeBodies(const Float &speedSq)
+	{
+		for (const SleepingContact &contact : m_sleepingContacts)
+		{
+			if (contact.speedSq >= speedSq)
+			{
+				contact.body->wake();
+			}
+		}
+		m_sleepingContacts.clear();
+	}
+
+#pragma endregion Step
+
+#pragma region Fluid
+
+	/*
+	 * Offsets to the neighbours of one particle and one value of each, gathered before the kernels run over them
+	 * in lanes. The tail up to a whole lane sits a smoothing radius away where every kernel is zero.
+	 */
+	struct NeighbourColumns
+	{
+		FloatLanes dx, dy, dz, value;
+		UInt32 lanes;
+
+		inline void resize(const UInt32 &count)
+		{
+			lanes = (count + Wide::width - 1) / Wide::width;
+			if (dx.size() < lanes * Wide::width)
+			{
+				for (FloatLanes *column : {&dx, &dy, &dz, &value})
+				{
+					column->resize(lanes * Wide::width);
+				}
+			}
+		}
+
+		inline void pad(const UInt32 &count, const Float &radius)
+		{
+			for (UInt32 n = count; n < lanes * Wide::width; ++n)
+			{
+				dx[n] = radius;
+				dy[n] = dz[n] = value[n] = 0;
+			}
+		}
+
+		inline WideVec3 offsets(const UInt32 &lane) const
+		{
+			const UInt32 n = lane * Wide::width;
+			return WideVec3(Wide::load(&dx[n]), Wide::load(&dy[n]), Wide::load(&dz[n]));
+		}
+	};
+
+	/*
+	 * Poly6 weight without its constant, and the spiky gradient as -factor * offset
+	 */
+	inline void kernelLanes(const WideVec3 &offset, const Wide &radius, const Wide &radiusSq, const Wide &spiky, Wide &outWeight, Wide &outFactor)
+	{
+		const Wide zero(0.0);
+		const Wide rSq = offset.lengthSq();
+		const Wide inside = rSq < radiusSq;
+		const Wide diff = Wide::select(inside, radiusSq - rSq, zero);
+		outWeight = diff * diff * diff;
+
+		const Wide valid = inside & (rSq > zero);
+		const Wide r = Wide::sqrt(Wide::select(valid, rSq, Wide(1.0)));
+		const Wide rest = radius - r;
+		outFactor = Wide::select(valid, spiky * rest * rest / r, zero);
+	}
+
+	inline Float sumLanes(const Wide &value)
+	{
+		alignas(Wide::alignment) Float lanes[Wide::width];
+		value.store(lanes);
+		Float sum = 0;
+		for (UInt32 l = 0; l < Wide::width; ++l)
+		{
+			sum += lanes[l];
+		}
+		return sum;
+	}
+
+	inline Float poly6(const Float &radius)
+	{
+		const Float cube = radius * radius * radius;
+		return 315.0 / (64.0 * Math::Pi * cube * cube * cube);
+	}
+
+	inline Float spikyGradient(const Float &radius)
+	{
+		const Float cube = radius * radius * radius;
+		return 45.0 / (Math::Pi * cube * cube);
+	}
+
+	/*
+	 * Rest density and the constraint gradient of a particle inside a lattice two radii wide
+	 */
+	void ParticleSystem::updateKernel()
+	{
+		m_kernelRadius = smoothingRadius > 0 ? smoothingRadius : 4 * m_maxRadius;
+		const Float h = m_kernelRadius;
+		const Float hSq = h * h;
+		const Float spacing = 2 * m_maxRadius;
+		const Int32 n = (Int32)Math::ceil(h / spacing);
+
+		Float weight = 0;
+		Float gradientSq = 0;
+		for (Int32 x = -n; x <= n; ++x)
+		{
+			for (Int32 y = -n; y <= n; ++y)
+			{
+				for (Int32 z = -n; z <= n; ++z)
+				{
+					const Float rSq = Vec3((Float)x, (Float)y, (Float)z).lengthSq() * spacing * spacing;
+					if (rSq >= hSq)
+					{
+						continue;
+					}
+
+					weight += (hSq - rSq) * (hSq - rSq) * (hSq - rSq);
+					if (rSq > 0)
+					{
+						const Float r = Math::sqrt(rSq);
+						const Float factor = spikyGradient(h) * (h - r) * (h - r) / r;
+						gradientSq += factor * factor * rSq;
+					}
+				}
+			}
+		}
+
+		m_restDensity = poly6(h) * weight;
+		m_restGradient = gradientSq / (m_restDensity * m_restDensity);
+	}
+
+	/*
+	 * Neighbour lists in hashed order with a skin around the smoothing radius, found once per step.
+	 * Each batch lists its particles on its own, the lists are joined once their sizes are known.
+	 */
+	void ParticleSystem::findNeighbours(ITaskScheduler &scheduler)
+	{
+		const Float reach = m_kernelRadius * (1 + k_neighbourSkin);
+		const Float reachSq = reach * reach;
+		buildHash(reach, scheduler);
+		gatherHashed(m_sorted, scheduler);
+
+		const UInt32 batchCount = (m_count + k_batch - 1) / k_batch;
+		if (m_batchNeighbours.size() < batchCount)
+		{
+			m_batchNeighbours.resize(batchCount);
+		}
+
+		m_neighbourStart.resize(m_count + 1);
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			vector<UInt32> &neighbours = m_batchNeighbours[begin / k_batch];
+			neighbours.clear();
+
+			UInt32 ranges[2 * k_maxNeighbourRanges];
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				const HashedParticle &p = m_hashed[k];
+				const UInt32 first = neighbours.size();
+				for (UInt32 r = 0, rangeCount = neighbourRanges(m_sorted[k], ranges); r < rangeCount; ++r)
+				{
+					for (UInt32 n = ranges[2 * r], last = ranges[2 * r + 1]; n < last; ++n)
+					{
+						const HashedParticle &q = m_hashed[n];
+						if (n != k && Vec3(p.x - q.x, p.y - q.y, p.z - q.z).lengthSq() < reachSq)
+						{
+							neighbours.push_back(n);
+						}
+					}
+				}
+				m_neighbourStart[k + 1] = neighbours.size() - first;
+			}
+		});
+
+		m_neighbourStart[0] = 0;
+		for (UInt32 k = 0; k < m_count; ++k)
+		{
+			m_neighbourStart[k + 1] += m_neighbourStart[k];
+		}
+
+		m_neighbours.resize(m_neighbourStart[m_count]);
+		// a batch's list covers its whole range, only the start is needed
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &)
+		{
+			const vector<UInt32> &neighbours = m_batchNeighbours[begin / k_batch];
+			std::copy(neighbours.begin(), neighbours.end(), m_neighbours.begin() + m_neighbourStart[begin]);
+		});
+
+		m_neighbourOrder.swap(m_sorted);
+	}
+
+	/*
+	 * Position based fluids: one Jacobi pass of density constraints. They are clamped so particles only push apart,
+	 * which keeps them from clustering without artificial pressure. Corrections go to m_dx like particle contacts.
+	 */
+	void ParticleSystem::solveDensity(ITaskScheduler &scheduler)
+	{
+		gatherHashed(m_neighbourOrder, scheduler);
+
+		const Float h = m_kernelRadius;
+		const Float poly = poly6(h);
+		const Float spiky = spikyGradient(h);
+		const Float restInv = 1 / m_restDensity;
+		const Float epsilon = relaxation * m_restGradient;
+		const Float selfWeight = h * h * h * h * h * h;
+
+		// offsets from hashed particle k to its neighbours, and their lambdas
+		const auto gather = [&, this](const UInt32 &k, NeighbourColumns &columns, const bool &lambdas)
+		{
+			const HashedParticle &p = m_hashed[k];
+			const UInt32 first = m_neighbourStart[k];
+			const UInt32 count = m_neighbourStart[k + 1] - first;
+			columns.resize(count);
+			for (UInt32 n = 0; n < count; ++n)
+			{
+				const UInt32 j = m_neighbours[first + n];
+				const HashedParticle &q = m_hashed[j];
+				columns.dx[n] = p.x - q.x;
+				columns.dy[n] = p.y - q.y;
+				columns.dz[n] = p.z - q.z;
+				columns.value[n] = lambdas ? m_lambda[j] : 0;
+			}
+			columns.pad(count, h);
+		};
+
+		m_lambda.resize(m_count);
+		m_density.resize(m_count);
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			const Wide radius(h), radiusSq(h * h), spikyWide(spiky);
+			NeighbourColumns columns;
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				gather(k, columns, false);
+				Wide weight(0.0), gradientSq(0.0);
+				WideVec3 gradient(Wide(0.0), Wide(0.0), Wide(0.0));
+				for (UInt32 lane = 0; lane < columns.lanes; ++lane)
+				{
+					const WideVec3 offset = columns.offsets(lane);
+					Wide w, factor;
+					kernelLanes(offset, radius, radiusSq, spikyWide, w, factor);
+					weight = weight + w;
+					gradient = gradient + offset * factor;
+					gradientSq = gradientSq + factor * factor * offset.lengthSq();
+				}
+
+				const Float density = poly * (sumLanes(weight) + selfWeight);
+				const Float C = density * restInv - 1;
+				const Vec3 sum(sumLanes(gradient.x), sumLanes(gradient.y), sumLanes(gradient.z));
+				m_density[k] = density;
+				m_lambda[k] = C > 0 ? -C / ((sumLanes(gradientSq) + sum.lengthSq()) * restInv * restInv + epsilon) : 0;
+			}
+		});
+
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			const Wide radius(h), radiusSq(h * h), spikyWide(spiky);
+			NeighbourColumns columns;
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				const UInt32 i = m_neighbourOrder[k];
+				if (m_hashed[k].invMass == 0)
+				{
+					m_dx[i] = m_dy[i] = m_dz[i] = 0;
+					continue;
+				}
+
+				gather(k, columns, true);
+				const Wide lambda(m_lambda[k]);
+				WideVec3 correction(Wide(0.0), Wide(0.0), Wide(0.0));
+				for (UInt32 lane = 0; lane < columns.lanes; ++lane)
+				{
+					const WideVec3 offset = columns.offsets(lane);
+					Wide w, factor;
+					kernelLanes(offset, radius, radiusSq, spikyWide, w, factor);
+					const Wide scale = lambda + Wide::load(&columns.value[lane * Wide::width]);
+
+					// the gradient is -factor * offset
+					correction = correction - offset * (factor * scale);
+				}
+
+				m_dx[i] = sumLanes(correction.x) * restInv;
+				m_dy[i] = sumLanes(correction.y) * restInv;
+				m_dz[i] = sumLanes(correction.z) * restInv;
+			}
+		});
+	}
+
+	/*
+	 * XSPH viscosity and vorticity confinement from the velocities after differentiation, Jacobi like the density
+	 */
+	void ParticleSystem::solveVelocities(const Float &dt, ITaskScheduler &scheduler)
+	{
+		if (!m_fluid || m_count == 0 || (viscosity <= 0 && vorticity <= 0))
+		{
+			return;
+		}
+
+		gatherHashed(m_neighbourOrder, scheduler);
+		m_hashedVelocity.resize(m_count);
+		m_vorticity.assign(m_count, Vec3::zero);
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				m_hashedVelocity[k] = velocity(m_neighbourOrder[k]);
+			}
+		});
+
+		const Float h = m_kernelRadius;
+		const Float hSq = h * h;
+		const Float poly = poly6(h);
+		const Float spiky = spikyGradient(h);
+		const auto forEachNeighbour = [&, this](const UInt32 &k, const auto &callback)
+		{
+			const HashedParticle &p = m_hashed[k];
+			for (UInt32 n = m_neighbourStart[k], last = m_neighbourStart[k + 1]; n < last; ++n)
+			{
+				const UInt32 j = m_neighbours[n];
+				const HashedParticle &q = m_hashed[j];
+				const Vec3 offset(p.x - q.x, p.y - q.y, p.z - q.z);
+				const Float rSq = offset.lengthSq();
+				if (rSq < hSq && rSq > 0)
+				{
+					const Float r = Math::sqrt(rSq);
+					const Float diff = hSq - rSq;
+					callback(j, offset, poly * diff * diff * diff, spiky * (h - r) * (h - r) / r, 1 / m_density[j]);
+				}
+			}
+		};
+
+		if (vorticity > 0)
+		{
+			scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+			{
+				for (UInt32 k = begin; k < end; ++k)
+				{
+					Vec3 curl = Vec3::zero;
+					forEachNeighbour(k, [&](const UInt32 &j, const Vec3 &offset, const Float &, const Float &factor, const Float &volume)
+					{
+						curl += (m_hashedVelocity[j] - m_hashedVelocity[k]).cross(offset * (factor * volume));
+					});
+					m_vorticity[k] = curl;
+				}
+			});
+		}
+
+		scheduler.parallelFor(m_count, k_batch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 k = begin; k < end; ++k)
+			{
+				if (m_hashed[k].invMass == 0)
+				{
+					continue;
+				}
+
+				const Vec3 &v = m_hashedVelocity[k];
+				const Float curl = m_vorticity[k].length();
+				Vec3 blend = Vec3::zero;
+				Vec3 curlGradient = Vec3::zero;
+				forEachNeighbour(k, [&](const UInt32 &j, const Vec3 &offset, const Float &weight, const Float &factor, const Float &volume)
+				{
+					blend += (m_hashedVelocity[j] - v) * (weight * volume);
+					curlGradient -= offset * (factor * (m_vorticity[j].length() - curl) * volume);
+				});
+
+				Vec3 result = v + blend * viscosity;
+				const Float gradientLength = curlGradient.length();
+				if (vorticity > 0 && gradientLength > Math::Epsilon)
+				{
+					result += (curlGradient * (1 / gradientLength)).cross(m_vorticity[k]) * (vorticity * dt);
+				}
+				setVelocity(m_neighbourOrder[k], result);
+			}
+		});
+	}
+
+#pragma endregion Fluid
+}
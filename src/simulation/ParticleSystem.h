@@ -0,0 +1,280 @@
+/*
+ * Spheres without rotation stored as columns of Float rather than as Bodies, for counts far beyond what the
+ * body pipeline handles. Integration runs Wide::width particles at a time, neighbours come from a spatial
+ * hash rebuilt every substep and colliders are queried once per step and batch of neighbouring particles.
+ * The world steps particles inside its substeps, they collide with each other and with colliders.
+ * Distance, bending and volume constraints between particles make cloth, ropes and soft bodies,
+ * attachments and contacts couple them with bodies both ways.
+ * A fluid system replaces the particle contacts with position based fluid density constraints.
+ */
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "math/Math.h"
+#include "math/Wide.h"
+#include "data/AlignedAllocator.h"
+#include "collision/broadphase/IBroadphase.h"
+#include "collision/narrowphase/INarrowphase.h"
+#include "tasks/ITaskScheduler.h"
+#include "ConstraintColoring.h"
+#include "Body.h"
+#include <vector>
+
+using namespace std;
+
+namespace Positional
+{
+	typedef vector<Float, AlignedAllocator<Float, Wide::alignment>> FloatLanes;
+
+	class ParticleSystem
+	{
+		friend class World;
+	private:
+		/*
+		 * Static collider near a batch of particles, with what the narrowphase needs against a sphere
+		 */
+		struct StaticCandidate
+		{
+			const Collider *collider;
+			Bounds bounds;
+			Collision::PenetrationFunction compute;
+		};
+
+		/*
+		 * Collider of a body near one particle, solved one after another since many particles share a body
+		 */
+		struct BodyCandidate
+		{
+			UInt32 particle;
+			const Collider *collider;
+			Body *body;
+			Collision::PenetrationFunction compute;
+		};
+
+		/*
+		 * Keeps a and b at restLength apart
+		 */
+		struct DistanceConstraint
+		{
+			UInt32 a, b;
+			Float restLength;
+			Float compliance;
+		};
+
+		/*
+		 * Keeps b at restDistance from the centroid of a, b and c, straight when b started on the line between a and c
+		 */
+		struct BendingConstraint
+		{
+			UInt32 a, b, c;
+			Float restDistance;
+			Float compliance;
+		};
+
+		/*
+		 * Keeps the signed volume of the tetrahedron, stored six times over as the triple product of its edges
+		 */
+		struct VolumeConstraint
+		{
+			UInt32 a, b, c, d;
+			Float restVolume;
+			Float compliance;
+		};
+
+		/*
+		 * Pins a particle to a point in body space, world space without a body
+		 */
+		struct Attachment
+		{
+			UInt32 particle;
+			Ref<Body> body;
+			// the point is in body space, the attachment goes with the body
+			bool onBody;
+			Vec3 point;
+			Float compliance;
+			// resolved by beginStep, Body::immovable without a body
+			Body *resolved;
+		};
+
+		// columns are padded to a multiple of Wide::width, padding has no mass and never moves
+		FloatLanes m_x, m_y, m_z;
+		FloatLanes m_vx, m_vy, m_vz;
+		// position at the start of the substep
+		FloatLanes m_px, m_py, m_pz;
+		// correction from neighbouring particles in this substep
+		FloatLanes m_dx, m_dy, m_dz;
+		FloatLanes m_invMass;
+		vector<Float> m_radius;
+		UInt32 m_count;
+		Float m_maxRadius;
+
+		// spatial hash of the current positions, particles of bucket b are m_sorted[m_bucketStart[b]] to m_sorted[m_bucketStart[b + 1]]
+		UInt32 m_bucketMask;
+		vector<UInt32> m_bucketStart;
+		vector<UInt32> m_sorted;
+		vector<UInt32> m_bucket;
+		// cell coordinates per particle, three in a row
+		vector<Int32> m_cells;
+
+		/*
+		 * Copy of the particle at m_sorted[k], so neighbours in a bucket are read from one contiguous range
+		 */
+		struct HashedParticle
+		{
+			Float x, y, z;
+			Float radius;
+			Float invMass;
+		};
+		vector<HashedParticle> m_hashed;
+
+		// hashed order at the start of the step, colliders near m_staticOrder[b * k_staticBatch] to m_staticOrder[(b + 1) * k_staticBatch]
+		vector<UInt32> m_staticOrder;
+		vector<vector<StaticCandidate>> m_batchStatics;
+		vector<vector<BodyCandidate>> m_batchBodies;
+
+		vector<DistanceConstraint> m_distances;
+		vector<BendingConstraint> m_bendings;
+		vector<VolumeConstraint> m_volumes;
+		vector<Attachment> m_attachments;
+		/*
+		 * Sleeping body a particle ran into, with the particle's speed then
+		 */
+		struct SleepingContact
+		{
+			Body *body;
+			Float speedSq;
+		};
+		// contacts of this step, the world wakes the bodies fast particles ran into
+		vector<SleepingContact> m_sleepingContacts;
+		// colors of constraints sharing no particle, rebuilt by beginStep after constraints were added
+		ConstraintColoring m_distanceColors;
+		ConstraintColoring m_bendingColors;
+		ConstraintColoring m_volumeColors;
+		bool m_colorsDirty;
+
+		// fluid neighbours of hashed particle k are m_neighbours[m_neighbourStart[k]] to m_neighbours[m_neighbourStart[k + 1]]
+		bool m_fluid;
+		vector<UInt32> m_neighbourOrder;
+		vector<UInt32> m_neighbourStart;
+		vector<UInt32> m_neighbours;
+		vector<vector<UInt32>> m_batchNeighbours;
+		// per hashed particle
+		vector<Vec3> m_hashedVelocity;
+		vector<Vec3> m_vorticity;
+		vector<Float> m_lambda;
+		vector<Float> m_density;
+		Float m_kernelRadius;
+		Float m_restDensity;
+		Float m_restGradient;
+
+		// template for the sphere handed to the narrowphase
+		Collider m_sphere;
+
+		static const UInt32 k_batch = 256;
+		static const UInt32 k_staticBatch = 32;
+		static const UInt32 k_maxNeighbourRanges = 27;
+
+		// z is added rather than hashed, so a column of cells lands in consecutive buckets and stays close in memory
+		inline UInt32 bucketOf(const Int32 &x, const Int32 &y, const Int32 &z) const
+		{
+			return (((UInt32)x * 73856093u ^ (UInt32)y * 19349663u) + (UInt32)z) & m_bucketMask;
+		}
+
+		void buildHash(const Float &cellSize, ITaskScheduler &scheduler);
+		void gatherHashed(const vector<UInt32> &order, ITaskScheduler &scheduler);
+		UInt32 neighbourRanges(const UInt32 &i, UInt32 *outRanges) const;
+		void findColliders(const Float &deltaTime, const Vec3 &gravity, ITaskScheduler &scheduler, const Collision::IBroadphase &broadphase, const Collision::INarrowphase &narrowphase, Store<Body> &bodies);
+		void collideParticles(ITaskScheduler &scheduler);
+		void collideStatics(ITaskScheduler &scheduler);
+		void collideBodies();
+
+		void findNeighbours(ITaskScheduler &scheduler);
+		void updateKernel();
+		void solveDensity(ITaskScheduler &scheduler);
+
+		void colorConstraints();
+		void solveColored(const ConstraintColoring &coloring, ITaskScheduler &scheduler, const function<void(const UInt32 &)> &solve);
+		void solveConstraints(const Float &dtInvSq, ITaskScheduler &scheduler);
+		void solveDistance(const DistanceConstraint &constraint, const Float &dtInvSq);
+		void solveBending(const BendingConstraint &constraint, const Float &dtInvSq);
+		void solveVolume(const VolumeConstraint &constraint, const Float &dtInvSq);
+		void solveAttachment(const Attachment &attachment, const Float &dtInvSq);
+
+		/*
+		 * Called by the world, beginStep once per step and the others once per substep
+		 */
+		void beginStep(const Float &deltaTime, const Vec3 &gravity, ITaskScheduler &scheduler, const Collision::IBroadphase &broadphase, const Collision::INarrowphase &narrowphase, Store<Body> &bodies);
+		void integrate(const Float &dt, const Vec3 &gravity, ITaskScheduler &scheduler);
+		void solvePositions(const Float &dtInvSq, ITaskScheduler &scheduler);
+		void differentiate(const Float &dtInv, ITaskScheduler &scheduler);
+		void solveVelocities(const Float &dt, ITaskScheduler &scheduler);
+		void wakeBodies(const Float &speedSq);
+
+	public:
+		// collide particles with each other, colliders are always collided. Fluids always interact through their density.
+		bool selfCollision;
+		// colliders sharing a bit with this are collided
+		UInt32 mask;
+		// push bodies back, otherwise bodies act on particles like static colliders
+		bool pushBodies;
+
+		/*
+		 * Fluid settings. The rest density is that of particles two radii apart, zero smoothing radius is four radii.
+		 * Relaxation softens the density constraint relative to a particle at rest,
+		 * viscosity blends velocities with the neighbours in [0, 1] and vorticity restores swirl lost to damping.
+		 */
+		Float smoothingRadius;
+		Float relaxation;
+		Float viscosity;
+		Float vorticity;
+
+		ParticleSystem(const bool &fluid = false);
+
+		/*
+		 * Returns the index of the new particle, zero mass particles are moved only by their velocity
+		 */
+		UInt32 add(const Vec3 &position, const Float &radius, const Float &mass, const Vec3 &velocity = Vec3::zero);
+		void clear();
+
+		/*
+		 * Constraints take their rest state from the current positions and return their index among constraints of their kind.
+		 * Compliance is inverse stiffness as in Constraint::computeCorrections, zero is rigid.
+		 * Neighbours closer than two radii push each other apart, keep radii below half the spacing when self colliding.
+		 */
+		UInt32 addDistance(const UInt32 &a, const UInt32 &b, const Float &compliance = 0);
+		UInt32 addBending(const UInt32 &a, const UInt32 &b, const UInt32 &c, const Float &compliance = 0);
+		UInt32 addVolume(const UInt32 &a, const UInt32 &b, const UInt32 &c, const UInt32 &d, const Float &compliance = 0);
+
+		/*
+		 * Pins the particle where it is now on the body, pulling the body as well unless it is static or sleeping.
+		 * Destroying the body drops its attachments, those after it move down one index.
+		 */
+		UInt32 attach(const UInt32 &particle, const Ref<Body> &body, const Float &compliance = 0);
+		void clearConstraints();
+
+		inline UInt32 distanceCount() const { return m_distances.size(); }
+		inline UInt32 bendingCount() const { return m_bendings.size(); }
+		inline UInt32 volumeCount() const { return m_volumes.size(); }
+		inline UInt32 attachmentCount() const { return m_attachments.size(); }
+
+		inline UInt32 count() const { return m_count; }
+		inline bool isFluid() const { return m_fluid; }
+
+		inline Vec3 position(const UInt32 &i) const { return Vec3(m_x[i], m_y[i], m_z[i]); }
+		inline void setPosition(const UInt32 &i, const Vec3 &position) { m_x[i] = position.x; m_y[i] = position.y; m_z[i] = position.z; }
+
+		inline Vec3 velocity(const UInt32 &i) const { return Vec3(m_vx[i], m_vy[i], m_vz[i]); }
+		inline void setVelocity(const UInt32 &i, const Vec3 &velocity) { m_vx[i] = velocity.x; m_vy[i] = velocity.y; m_vz[i] = velocity.z; }
+
+		inline Float radius(const UInt32 &i) const { return m_radius[i]; }
+		inline Float inverseMass(const UInt32 &i) const { return m_invMass[i]; }
+
+		/*
+		 * Position columns for reading many particles at once, count() entries each
+		 */
+		inline const Float *positionsX() const { return m_x.data(); }
+		inline const Float *positionsY() const { return m_y.data(); }
+		inline const Float *positionsZ() const { return m_z.data(); }
+	};
+}
+#endif // PARTICLE_SYSTEM_H
@@ -0,0 +1,258 @@
+#include "RigidBody.h"
+#include "math/Wide.h"
+
+namespace Positional
+{
+#pragma region Integrate
+	/*
+	 * Velocities and poses of a batch of rigid bodies, padding lanes repeat the last body and are not written back
+	 */
+	struct IntegrateLanes
+	{
+		alignas(Wide::alignment) Float px[Wide::width];
+		alignas(Wide::alignment) Float py[Wide::width];
+		alignas(Wide::alignment) Float pz[Wide::width];
+		alignas(Wide::alignment) Float qx[Wide::width];
+		alignas(Wide::alignment) Float qy[Wide::width];
+		alignas(Wide::alignment) Float qz[Wide::width];
+		alignas(Wide::alignment) Float qw[Wide::width];
+		alignas(Wide::alignment) Float mpx[Wide::width];
+		alignas(Wide::alignment) Float mpy[Wide::width];
+		alignas(Wide::alignment) Float mpz[Wide::width];
+		alignas(Wide::alignment) Float vx[Wide::width];
+		alignas(Wide::alignment) Float vy[Wide::width];
+		alignas(Wide::alignment) Float vz[Wide::width];
+		alignas(Wide::alignment) Float wx[Wide::width];
+		alignas(Wide::alignment) Float wy[Wide::width];
+		alignas(Wide::alignment) Float wz[Wide::width];
+		// velocity change from gravity and forces
+		alignas(Wide::alignment) Float dvx[Wide::width];
+		alignas(Wide::alignment) Float dvy[Wide::width];
+		alignas(Wide::alignment) Float dvz[Wide::width];
+		Body *body[Wide::width];
+
+		inline void gather(const UInt32 &lane, Body *b, const Float &dt, const Vec3 &gravity)
+		{
+			body[lane] = b;
+			b->prePose = b->pose;
+
+			Vec3 dv = dt * gravity;
+			if (b->forces.linear != Vec3::zero)
+			{
+				dv = dv + dt * b->invMass * b->forces.linear;
+				b->forces.linear = Vec3::zero;
+			}
+
+			if (b->forces.angular != Vec3::zero)
+			{
+				Vec3 dOmega = b->massPose.inverseRotate(b->pose.inverseRotate(b->forces.angular * dt));
+				dOmega.x *= b->invInertia.x;
+				dOmega.y *= b->invInertia.y;
+				dOmega.z *= b->invInertia.z;
+				b->velocity.angular += b->pose.rotate(b->massPose.rotate(dOmega));
+				b->forces.angular = Vec3::zero;
+			}
+
+			const Pose &pose = b->pose;
+			px[lane] = pose.position.x; py[lane] = pose.position.y; pz[lane] = pose.position.z;
+			qx[lane] = pose.rotation.x; qy[lane] = pose.rotation.y; qz[lane] = pose.rotation.z; qw[lane] = pose.rotation.w;
+			mpx[lane] = b->massPose.position.x; mpy[lane] = b->massPose.position.y; mpz[lane] = b->massPose.position.z;
+			vx[lane] = b->velocity.linear.x; vy[lane] = b->velocity.linear.y; vz[lane] = b->velocity.linear.z;
+			wx[lane] = b->velocity.angular.x; wy[lane] = b->velocity.angular.y; wz[lane] = b->velocity.angular.z;
+			dvx[lane] = dv.x; dvy[lane] = dv.y; dvz[lane] = dv.z;
+		}
+
+		inline void pad(const UInt32 &lane)
+		{
+			body[lane] = nullptr;
+			px[lane] = px[0]; py[lane] = py[0]; pz[lane] = pz[0];
+			qx[lane] = qx[0]; qy[lane] = qy[0]; qz[lane] = qz[0]; qw[lane] = qw[0];
+			mpx[lane] = mpx[0]; mpy[lane] = mpy[0]; mpz[lane] = mpz[0];
+			vx[lane] = vx[0]; vy[lane] = vy[0]; vz[lane] = vz[0];
+			wx[lane] = wx[0]; wy[lane] = wy[0]; wz[lane] = wz[0];
+			dvx[lane] = dvx[0]; dvy[lane] = dvy[0]; dvz[lane] = dvz[0];
+		}
+	};
+
+	/*
+	 * The same steps as the velocity and position update of Body::applyRotation for all lanes
+	 */
+	inline void integrateLanes(IntegrateLanes &lanes, const UInt32 &count, const Float &dt)
+	{
+		for (UInt32 i = count; i < Wide::width; ++i)
+		{
+			lanes.pad(i);
+		}
+
+		const Wide step(dt);
+		const WideVec3 velocity = WideVec3(Wide::load(lanes.vx), Wide::load(lanes.vy), Wide::load(lanes.vz))
+			+ WideVec3(Wide::load(lanes.dvx), Wide::load(lanes.dvy), Wide::load(lanes.dvz));
+		const WideVec3 position = WideVec3(Wide::load(lanes.px), Wide::load(lanes.py), Wide::load(lanes.pz)) + velocity * step;
+		const WideQuat rotation(Wide::load(lanes.qx), Wide::load(lanes.qy), Wide::load(lanes.qz), Wide::load(lanes.qw));
+		const WideVec3 massPosition(Wide::load(lanes.mpx), Wide::load(lanes.mpy), Wide::load(lanes.mpz));
+		const WideVec3 omega(Wide::load(lanes.wx), Wide::load(lanes.wy), Wide::load(lanes.wz));
+
+		// clamp max rotations per substep
+		const Wide maxPhi(0.5);
+		const Wide phi = Wide::sqrt(omega.lengthSq());
+		const Wide clamp = phi * step > maxPhi;
+		const Wide qh = Wide::select(clamp, maxPhi / Wide::select(clamp, phi, Wide(1.0)), step);
+
+		const WideVec3 worldCOM = position + rotation.rotate(massPosition);
+
+		const Wide half(0.5);
+		const WideQuat dq = WideQuat(omega.x * qh, omega.y * qh, omega.z * qh, Wide(0.0)) * rotation;
+		const WideQuat rotated = WideQuat(
+			rotation.x + half * dq.x,
+			rotation.y + half * dq.y,
+			rotation.z + half * dq.z,
+			rotation.w + half * dq.w).normalized();
+
+		// maintain center of mass position in world space
+		const WideVec3 moved = worldCOM - ((position + rotated.rotate(massPosition)) - position);
+
+		alignas(Wide::alignment) Float out[10][Wide::width];
+		velocity.x.store(out[0]); velocity.y.store(out[1]); velocity.z.store(out[2]);
+		moved.x.store(out[3]); moved.y.store(out[4]); moved.z.store(out[5]);
+		rotated.x.store(out[6]); rotated.y.store(out[7]); rotated.z.store(out[8]); rotated.w.store(out[9]);
+
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			Body &body = *lanes.body[i];
+			body.velocity.linear = Vec3(out[0][i], out[1][i], out[2][i]);
+			body.pose.position = Vec3(out[3][i], out[4][i], out[5][i]);
+			body.pose.rotation = Quat(out[6][i], out[7][i], out[8][i], out[9][i]);
+			body.poseChanged();
+		}
+	}
+
+	void RigidBody::integrate(Body *const *bodies, const UInt32 &count, const Float &dt, const Vec3 &gravity)
+	{
+		IntegrateLanes lanes;
+		UInt32 used = 0;
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			lanes.gather(used++, bodies[i], dt, gravity);
+			if (used == Wide::width)
+			{
+				integrateLanes(lanes, used, dt);
+				used = 0;
+			}
+		}
+
+		if (used > 0)
+		{
+			integrateLanes(lanes, used, dt);
+		}
+	}
+#pragma endregion Integrate
+
+#pragma region Differentiate
+	/*
+	 * Poses before and after the substep of a batch of rigid bodies
+	 */
+	struct DifferentiateLanes
+	{
+		alignas(Wide::alignment) Float px[Wide::width];
+		alignas(Wide::alignment) Float py[Wide::width];
+		alignas(Wide::alignment) Float pz[Wide::width];
+		alignas(Wide::alignment) Float qx[Wide::width];
+		alignas(Wide::alignment) Float qy[Wide::width];
+		alignas(Wide::alignment) Float qz[Wide::width];
+		alignas(Wide::alignment) Float qw[Wide::width];
+		alignas(Wide::alignment) Float ppx[Wide::width];
+		alignas(Wide::alignment) Float ppy[Wide::width];
+		alignas(Wide::alignment) Float ppz[Wide::width];
+		alignas(Wide::alignment) Float pqx[Wide::width];
+		alignas(Wide::alignment) Float pqy[Wide::width];
+		alignas(Wide::alignment) Float pqz[Wide::width];
+		alignas(Wide::alignment) Float pqw[Wide::width];
+		alignas(Wide::alignment) Float mpx[Wide::width];
+		alignas(Wide::alignment) Float mpy[Wide::width];
+		alignas(Wide::alignment) Float mpz[Wide::width];
+		Body *body[Wide::width];
+
+		inline void gather(const UInt32 &lane, Body *b)
+		{
+			body[lane] = b;
+			b->preVelocity = b->velocity;
+
+			const Pose &pose = b->pose;
+			const Pose &prePose = b->prePose;
+			px[lane] = pose.position.x; py[lane] = pose.position.y; pz[lane] = pose.position.z;
+			qx[lane] = pose.rotation.x; qy[lane] = pose.rotation.y; qz[lane] = pose.rotation.z; qw[lane] = pose.rotation.w;
+			ppx[lane] = prePose.position.x; ppy[lane] = prePose.position.y; ppz[lane] = prePose.position.z;
+			pqx[lane] = prePose.rotation.x; pqy[lane] = prePose.rotation.y; pqz[lane] = prePose.rotation.z; pqw[lane] = prePose.rotation.w;
+			mpx[lane] = b->massPose.position.x; mpy[lane] = b->massPose.position.y; mpz[lane] = b->massPose.position.z;
+		}
+
+		inline void pad(const UInt32 &lane)
+		{
+			body[lane] = nullptr;
+			px[lane] = px[0]; py[lane] = py[0]; pz[lane] = pz[0];
+			qx[lane] = qx[0]; qy[lane] = qy[0]; qz[lane] = qz[0]; qw[lane] = qw[0];
+			ppx[lane] = ppx[0]; ppy[lane] = ppy[0]; ppz[lane] = ppz[0];
+			pqx[lane] = pqx[0]; pqy[lane] = pqy[0]; pqz[lane] = pqz[0]; pqw[lane] = pqw[0];
+			mpx[lane] = mpx[0]; mpy[lane] = mpy[0]; mpz[lane] = mpz[0];
+		}
+	};
+
+	inline void differentiateLanes(DifferentiateLanes &lanes, const UInt32 &count, const Float &dtInv)
+	{
+		for (UInt32 i = count; i < Wide::width; ++i)
+		{
+			lanes.pad(i);
+		}
+
+		const WideVec3 position(Wide::load(lanes.px), Wide::load(lanes.py), Wide::load(lanes.pz));
+		const WideQuat rotation(Wide::load(lanes.qx), Wide::load(lanes.qy), Wide::load(lanes.qz), Wide::load(lanes.qw));
+		const WideVec3 prePosition(Wide::load(lanes.ppx), Wide::load(lanes.ppy), Wide::load(lanes.ppz));
+		const WideQuat preRotation(Wide::load(lanes.pqx), Wide::load(lanes.pqy), Wide::load(lanes.pqz), Wide::load(lanes.pqw));
+		const WideVec3 massPosition(Wide::load(lanes.mpx), Wide::load(lanes.mpy), Wide::load(lanes.mpz));
+
+		const WideVec3 linear = ((position + rotation.rotate(massPosition)) - (prePosition + preRotation.rotate(massPosition))) * Wide(dtInv);
+
+		// Quat::inverse
+		const Wide invNorm = Wide(1.0) / (preRotation.x * preRotation.x + preRotation.y * preRotation.y + preRotation.z * preRotation.z + preRotation.w * preRotation.w);
+		const Wide negInvNorm = -invNorm;
+		const WideQuat inverse(preRotation.x * negInvNorm, preRotation.y * negInvNorm, preRotation.z * negInvNorm, preRotation.w * invNorm);
+		const WideQuat dq = rotation * inverse;
+
+		// shorter arc, negated factors instead of negated lanes keep the signs of zeros as in the scalar code
+		const Float dtInv2 = 2 * dtInv;
+		const Wide scale = Wide::select(dq.w < Wide(0.0), Wide(-dtInv2), Wide(dtInv2));
+		const WideVec3 angular(dq.x * scale, dq.y * scale, dq.z * scale);
+
+		alignas(Wide::alignment) Float out[6][Wide::width];
+		linear.x.store(out[0]); linear.y.store(out[1]); linear.z.store(out[2]);
+		angular.x.store(out[3]); angular.y.store(out[4]); angular.z.store(out[5]);
+
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			Body &body = *lanes.body[i];
+			body.velocity.linear = Vec3(out[0][i], out[1][i], out[2][i]);
+			body.velocity.angular = Vec3(out[3][i], out[4][i], out[5][i]);
+		}
+	}
+
+	void RigidBody::differentiate(Body *const *bodies, const UInt32 &count, const Float &dtInv)
+	{
+		DifferentiateLanes lanes;
+		UInt32 used = 0;
+		for (UInt32 i = 0; i < count; ++i)
+		{
+			lanes.gather(used++, bodies[i]);
+			if (used == Wide::width)
+			{
+				differentiateLanes(lanes, used, dtInv);
+				used = 0;
+			}
+		}
+
+		if (used > 0)
+		{
+			differentiateLanes(lanes, used, dtInv);
+		}
+	}
+#pragma endregion Differentiate
+}
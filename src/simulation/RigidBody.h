@@ -7,32 +7,15 @@ namespace Positional
 {
 	struct RigidBody final
 	{
-		static void integrate(Body &body, const Float &dt, const Vec3 &gravity)
-		{
-			body.velocity.linear += dt * gravity + dt * body.invMass * body.forces.linear;
-			body.pose.position += dt * body.velocity.linear;
-
-			Vec3 dOmega = body.massPose.inverseRotate(body.pose.inverseRotate(body.forces.angular * dt));
-			dOmega.x *= body.invInertia.x;
-			dOmega.y *= body.invInertia.y;
-			dOmega.z *= body.invInertia.z;
-			dOmega = body.pose.rotate(body.massPose.rotate(dOmega));
-
-			body.velocity.angular += dOmega;
-			body.applyRotation(body.velocity.angular, dt);
-		}
-
-		static void differentiate(Body &body, const Float &dtInv)
-		{
-			body.velocity.linear = (body.pose.transform(body.massPose.position) - body.prePose.transform(body.massPose.position)) * dtInv;
-			const Quat dq = body.pose.rotation * body.prePose.rotation.inverse();
-			const Float dtInv2 = 2 * dtInv;
-			body.velocity.angular = dq.w >= 0 ?
-				Vec3(dq.x * dtInv2, dq.y * dtInv2, dq.z * dtInv2) :
-				Vec3(-dq.x * dtInv2, -dq.y * dtInv2, -dq.z * dtInv2);
-		}
+		/*
+		 * Kernels over awake rigid bodies, Wide::width at a time. Forces are only applied to bodies they were added to
+		 * and cleared while gathering, the quaternion update and its normalize run for all lanes together.
+		 */
+		static void integrate(Body *const *bodies, const UInt32 &count, const Float &dt, const Vec3 &gravity);
+		static void differentiate(Body *const *bodies, const UInt32 &count, const Float &dtInv);
 
 		static bool hasRotation() { return true; }
+		static bool isKinematic() { return false; }
 
 	private:
 		RigidBody() {}
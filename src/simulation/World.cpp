@@ -2,21 +2,82 @@
 #include "collision/broadphase/DBTBroadphase.h"
 #include "collision/narrowphase/GJKEPANarrowphase.h"
 #include "constraints/ContactConstraint.h"
+#include "constraints/WideContactSolver.h"
+#include <algorithm>
 
 namespace Positional
 {
-	World::World()
+	const UInt32 World::k_minParallelBatch;
+	const UInt32 World::k_bodyBatch;
+	const UInt32 World::k_pairBatch;
+
+	World::World() : World(std::max(thread::hardware_concurrency(), 1u) - 1)
+	{
+	}
+
+	World::World(const UInt32 &workerCount) : World(new JobSystem(workerCount), true)
+	{
+	}
+
+	World::World(ITaskScheduler &scheduler) : World(&scheduler, false)
+	{
+	}
+
+	World::World(ITaskScheduler *scheduler, const bool &ownsScheduler)
 	{
+		m_scheduler = scheduler;
+		m_ownsScheduler = ownsScheduler;
 		m_contactCount = 0;
+		m_kinematicCount = 0;
+		m_subSteps = 1;
+		m_maxPenetration = 0;
+		m_maxResidual = 0;
+		adaptiveSubSteps = false;
+		minSubSteps = 2;
+		maxSubSteps = 32;
+		maxSubStepMotion = 0.5;
+		penetrationTolerance = 0.01;
+		residualTolerance = 0.001;
+		m_accumulator = 0;
+		fixedDeltaTime = 1.0 / 60.0;
+		fixedSubSteps = 8;
+		maxCatchUpSteps = 4;
+		parallelThreshold = 256;
+		deterministic = false;
+		wideContacts = false;
+		cullUnreachablePairs = false;
 		gravity = Vec3::zero;
-		m_broadphase = new Collision::DBTBroadphase(2.0);
+		sleepLinearVelocity = 0.2;
+		sleepAngularVelocity = 0.5;
+		sleepTime = 0;
+		m_broadphase = new Collision::DBTBroadphase(2.0, m_scheduler);
 		m_narrowphase = new Collision::GJKEPANarrowphase();
+
+		m_colorGraph.add([this]()
+		{
+			colorJoints();
+		});
+		m_colorGraph.add([this]()
+		{
+			m_contactColors.build(m_bodies.count(), m_contactCount, [this](const UInt32 &i)
+			{
+				return make_pair(solvedBody(m_contacts[i].bodyA), solvedBody(m_contacts[i].bodyB));
+			});
+		});
 	}
 
 	World::~World()
 	{
 		delete m_broadphase;
 		delete m_narrowphase;
+		for (IConstraintPool *pool : m_constraintPools)
+		{
+			delete pool;
+		}
+		if (m_ownsScheduler)
+		{
+			delete m_scheduler;
+		}
 	}
 
 #pragma region Bodies
@@ -27,48 +88,199 @@ namespace Positional
 
 		m_colliders.erase([&, this](const Ref<Collider> &elRef)
 		{
-			const Collider &collider = elRef.get();
-			if (collider.body() == ref)
+			if (elRef.get().body() == ref)
 			{
-				if (collider.isStatic())
-				{
-					m_broadphase->removeStatic(elRef);
-				}
-				else
-				{
-					m_broadphase->remove(elRef);
-				}
+				removeFromBroadphase(elRef);
 				return true;
 			}
 			return false;
 		});
 
-		m_constraints.erase([&, this](const Ref<Constraint> &elRef)
+		for (IConstraintPool *pool : m_constraintPools)
+		{
+			if (pool == nullptr)
+			{
+				continue;
+			}
+
+			pool->erase([&, this](const Constraint &constraint)
+			{
+				if ((constraint.bodyA == ref && !constraint.bodyB.valid()) || (constraint.bodyB == ref && !constraint.bodyA.valid()))
+				{
+					releaseIgnore(constraint);
+					return true;
+				}
+				return false;
+			});
+		}
+
+		m_articulations.erase([&, this](const Ref<Articulation> &elRef)
 		{
-			const Constraint &constraint = elRef.get();
-			if ((constraint.bodyA == ref && !constraint.bodyB.valid()) || (constraint.bodyB == ref && !constraint.bodyA.valid()))
+			if (elRef.get().contains(ref))
 			{
+				ignoreLinks(elRef.get(), false);
 				return true;
 			}
 			return false;
 		});
 
+		if (ref.get().isKinematic())
+		{
+			m_kinematicCount--;
+		}
 		m_bodies.erase(ref);
 	}
 #pragma endregion // Bodies
 
-#pragma region Colliders
-	Ref<Collider> World::addCollider(const Ref<Body> &bodyRef, const Collider &collider)
+#pragma region Constraints
+	void World::releaseIgnore(const Constraint &constraint)
 	{
-		auto ref = m_colliders.store(collider);
-		if (collider.isStatic())
+		if (!constraint.ignoreCollisions)
 		{
-			m_broadphase->addStatic(ref);
+			return;
+		}
+
+		const auto it = m_ignoreBodies.find(constraint.ignoreKey);
+		if (it != m_ignoreBodies.end())
+		{
+			m_ignoreBodies.erase(it);
+		}
+	}
+
+	/*
+	 * One ignored pair per joint, as createConstraint adds for joints ignoring collisions
+	 */
+	void World::ignoreLinks(const Articulation &articulation, const bool &ignore)
+	{
+		if (!articulation.m_ignoreCollisions)
+		{
+			return;
+		}
+
+		for (const Articulation::Link &link : articulation.m_links)
+		{
+			if (!link.jointed)
+			{
+				continue;
+			}
+
+			const IdPair<UInt64> key(bodyKey(link.parent != NOT_FOUND ? articulation.m_links[link.parent].body : Body::null), bodyKey(link.body));
+			if (ignore)
+			{
+				m_ignoreBodies.insert(key);
+				continue;
+			}
+
+			const auto it = m_ignoreBodies.find(key);
+			if (it != m_ignoreBodies.end())
+			{
+				m_ignoreBodies.erase(it);
+			}
+		}
+	}
+
+	Ref<Articulation> World::createArticulation(const Articulation &articulation, const bool &ignoreCollisions)
+	{
+		// articulations are solved side by side, so no body may be a link of two
+		bool shared = false;
+		for (UInt32 i = 0, count = m_articulations.count(); i < count && !shared; ++i)
+		{
+			for (const Articulation::Link &link : articulation.m_links)
+			{
+				shared |= m_articulations[i].contains(link.body);
+			}
+		}
+
+		assert(!shared);
+		if (shared)
+		{
+			return Ref<Articulation>();
+		}
+
+		Ref<Articulation> ref = m_articulations.store(articulation);
+		ref.get().m_ignoreCollisions = ignoreCollisions;
+		ignoreLinks(ref.get(), true);
+		return ref;
+	}
+
+	void World::destroyArticulation(Ref<Articulation> ref)
+	{
+		if (ref.valid())
+		{
+			ignoreLinks(ref.get(), false);
+			m_articulations.erase(ref);
+		}
+	}
+
+	void World::ignoreCollisions(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB, const bool &ignore)
+	{
+		assert(colliderA.valid() && colliderB.valid());
+		const IdPair<UInt64> key(colliderA.id(), colliderB.id());
+		if (ignore)
+		{
+			m_ignoreColliders.insert(key);
 		}
 		else
 		{
-			m_broadphase->add(ref);
+			m_ignoreColliders.erase(key);
 		}
+	}
+
+	bool World::ignoresCollisions(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB) const
+	{
+		return m_ignoreColliders.count(IdPair<UInt64>(colliderA.id(), colliderB.id())) > 0;
+	}
+
+	/*
+	 * Jointed bodies and explicitly ignored colliders, both are symmetric
+	 */
+	bool World::isIgnored(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB) const
+	{
+		if (!m_ignoreBodies.empty())
+		{
+			const IdPair<UInt64> bodies(bodyKey(colliderA.get().body()), bodyKey(colliderB.get().body()));
+			if (m_ignoreBodies.count(bodies) > 0)
+			{
+				return true;
+			}
+		}
+
+		return !m_ignoreColliders.empty() && ignoresCollisions(colliderA, colliderB);
+	}
+#pragma endregion // Constraints
+
+#pragma region Particles
+	Ref<ParticleSystem> World::createParticleSystem(const bool &fluid)
+	{
+		return m_particleSystems.store(ParticleSystem(fluid));
+	}
+
+	void World::destroyParticleSystem(Ref<ParticleSystem> ref)
+	{
+		m_particleSystems.erase(ref);
+	}
+
+	void World::forEachParticleSystem(const function<void(ParticleSystem &)> &callback)
+	{
+		for (UInt32 i = 0, count = m_particleSystems.count(); i < count; ++i)
+		{
+			callback(m_particleSystems[i]);
+		}
+	}
+#pragma endregion // Particles
+
+#pragma region Colliders
+	Ref<Collider> World::addCollider(const Ref<Body> &bodyRef, const Collider &collider)
+	{
+		// meshes and heightfields add no mass and are only tested as static geometry
+		assert(!bodyRef.valid() || (collider.shapeId() & ShapeId::StaticOnly) == 0);
+		if (bodyRef.valid() && (collider.shapeId() & ShapeId::StaticOnly) != 0)
+		{
+			return Ref<Collider>();
+		}
+
+		auto ref = m_colliders.store(collider);
+		addToBroadphase(ref);
 
 		if (bodyRef.valid())
 		{
@@ -83,14 +295,7 @@ namespace Positional
 	void World::destroyCollider(Ref<Collider> ref)
 	{
 		assert(ref.valid());
-		if (ref.get().isStatic())
-		{
-			m_broadphase->removeStatic(ref);
-		}
-		else
-		{
-			m_broadphase->remove(ref);
-		}
+		removeFromBroadphase(ref);
 
 		// erase collider from body entry
 		if (ref.get().body().valid())
@@ -106,9 +311,53 @@ namespace Positional
 			}
 		}
 
+		// forget explicit ignores, ids are never reused
+		if (!m_ignoreColliders.empty())
+		{
+			const UInt64 id = ref.id();
+			for (auto it = m_ignoreColliders.begin(); it != m_ignoreColliders.end();)
+			{
+				it = (it->first == id || it->second == id) ? m_ignoreColliders.erase(it) : next(it);
+			}
+		}
+
 		// erase from store
 		m_colliders.erase(ref);
 	}
+
+	void World::addToBroadphase(const Ref<Collider> &ref)
+	{
+		const Collider &collider = ref.get();
+		if (collider.isStatic())
+		{
+			m_broadphase->addStatic(ref);
+		}
+		else if (collider.body().get().isKinematic())
+		{
+			m_broadphase->addKinematic(ref);
+		}
+		else
+		{
+			m_broadphase->add(ref);
+		}
+	}
+
+	void World::removeFromBroadphase(const Ref<Collider> &ref)
+	{
+		const Collider &collider = ref.get();
+		if (collider.isStatic())
+		{
+			m_broadphase->removeStatic(ref);
+		}
+		else if (collider.body().get().isKinematic())
+		{
+			m_broadphase->removeKinematic(ref);
+		}
+		else
+		{
+			m_broadphase->remove(ref);
+		}
+	}
 #pragma endregion // Colliders
 
 #pragma region Queries
@@ -128,7 +377,14 @@ namespace Positional
 
 	void World::forEachBody(const function<void(const Ref<Body> &)> &callback)
 	{
-		m_bodies.forEach(callback);
+		if (deterministic)
+		{
+			m_bodies.forEachOrdered(callback);
+		}
+		else
+		{
+			m_bodies.forEach(callback);
+		}
 	}
 
 	void World::forEachBoundsNode(const function<void(const Bounds &bounds)> &callback) const
@@ -151,10 +407,11 @@ namespace Positional
 		{
 			for (UInt32 i = 0; i < m_contactCount; ++i)
 			{
-				auto d = m_contacts[i].getData<ContactConstraint::Data>();
-				if (d->colliding)
+				const ContactConstraint::Data &contact = m_contacts[i];
+				if (contact.colliding)
 				{
-					auto result = CollisionResult(d->colliderA, d->colliderB, d->contact);
+					const auto &pair = m_pairs[contact.pair];
+					auto result = CollisionResult(pair.first, pair.second, contact.contact);
 					callback(result);
 				}
 			}
@@ -175,6 +432,41 @@ namespace Positional
 #pragma endregion // Queries
 
 #pragma region Simulation
+	// FNV-1a
+	inline void hashBytes(UInt64 &hash, const void *bytes, const size_t &size)
+	{
+		const UInt8 *data = static_cast<const UInt8 *>(bytes);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ data[i]) * 0x100000001b3ull;
+		}
+	}
+
+	inline void hashVec3(UInt64 &hash, const Vec3 &v)
+	{
+		const Float values[3] = {v.x, v.y, v.z};
+		hashBytes(hash, values, sizeof(values));
+	}
+
+	UInt64 World::stateHash() const
+	{
+		UInt64 hash = 0xcbf29ce484222325ull;
+		m_bodies.forEachOrdered([&](const Ref<Body> &ref)
+		{
+			const Body &body = ref.get();
+			const UInt64 id = ref.id();
+			const Float rotation[4] = {body.pose.rotation.x, body.pose.rotation.y, body.pose.rotation.z, body.pose.rotation.w};
+			const UInt8 sleeping = body.isSleeping() ? 1 : 0;
+			hashBytes(hash, &id, sizeof(id));
+			hashVec3(hash, body.pose.position);
+			hashBytes(hash, rotation, sizeof(rotation));
+			hashVec3(hash, body.velocity.linear);
+			hashVec3(hash, body.velocity.angular);
+			hashBytes(hash, &sleeping, sizeof(sleeping));
+		});
+		return hash;
+	}
+
 	void World::updateBroadphase()
 	{
 		m_broadphase->update(0);
@@ -182,95 +474,782 @@ namespace Positional
 
 	void World::simulate(const Float &deltaTime, const UInt32 &_subSteps)
 	{
-		const UInt32 subSteps = Math::max(_subSteps, 1);
-		const Float h = deltaTime / subSteps;
-		const Float hInv = 1.0/h;
-		const Float hInvSq = hInv*hInv;
+		// poses may have been set from outside since the last step
+		cacheColliderTransforms(true);
+
+		// before pairs are skipped for sleeping bodies, a woken link wakes its whole articulation
+		for (UInt32 i = 0, count = m_articulations.count(); i < count; ++i)
+		{
+			m_articulations[i].resolve(m_bodies);
+		}
+
+		// kinematic velocities for the whole step, before the broadphase predicts from them
+		if (m_kinematicCount > 0)
+		{
+			const Float dtInv = 1.0 / deltaTime;
+			for (UInt32 i = 0, count = m_bodies.count(); i < count; ++i)
+			{
+				m_bodies[i].aimAtTarget(dtInv);
+			}
+		}
 
 		// collect collision pairs
-		m_contactCount = 0;
+		m_pairs.clear();
 		m_broadphase->update(deltaTime);
 		m_broadphase->forEachOverlapPair([&, this](const pair<Ref<Collider>, Ref<Collider>> &pair)
 		{	
 			const Ref<Body> &bodyA = pair.first.get().body();
 			const Ref<Body> &bodyB = pair.second.get().body();
-			bool ignoreCollisions = false;
-			m_constraints.first([&](const Ref<Constraint> &ref)
-			{	
-				const Constraint &constraint = ref.get();
-				if ((constraint.bodyA == bodyA && constraint.bodyB == bodyB) || (constraint.bodyA == bodyB && constraint.bodyB == bodyA))
-				{
-					ignoreCollisions = constraint.ignoreCollisions;
-					return true;
-				}
-				return false;
-			});
 
-			if (ignoreCollisions)
+			// nothing moves between sleeping and static bodies
+			const bool activeA = bodyA.valid() && !bodyA.get().isSleeping();
+			const bool activeB = bodyB.valid() && !bodyB.get().isSleeping();
+			if (!activeA && !activeB)
 			{
 				return;
 			}
 
-			if (m_contactCount >= m_contacts.size())
+			if (isIgnored(pair.first, pair.second))
 			{
-				m_contacts.push_back(Constraint::create<ContactConstraint, ContactConstraint::Data>());
+				return;
 			}
 
-			m_contacts[m_contactCount].init<ContactConstraint::Data>(
-				bodyA,
-				bodyB,
-				false,
-				pair.first,
-				pair.second,
-				m_narrowphase
-			);
+			m_pairs.push_back(pair);
+		});
+
+		if (deterministic)
+		{
+			sortPairs();
+		}
+		collectContacts(deltaTime);
 
-			m_contactCount++;
+		// batches of constraints sharing no dynamic body
+		gatherJoints();
+		m_colorGraph.run(*m_scheduler);
+
+		const UInt32 subSteps = adaptiveSubSteps ? chooseSubSteps(deltaTime) : Math::max(_subSteps, 1);
+		const Float h = deltaTime / subSteps;
+		const Float hInv = 1.0/h;
+		const Float hInvSq = hInv*hInv;
+		m_subSteps = subSteps;
+
+		forEachParticleSystem([&, this](ParticleSystem &particles)
+		{
+			particles.beginStep(deltaTime, gravity, *m_scheduler, *m_broadphase, *m_narrowphase, m_bodies);
 		});
 
 		for (UInt32 s = 0; s < subSteps; ++s)
 		{
 			// constraint fores
-			for (UInt32 i = 0, count = m_constraints.count(); i < count; ++i)
+			solveJoints([&](IConstraintPool &pool, const UInt32 *indices, const UInt32 &count)
 			{
-				m_constraints[i].applyForces(h);
-			}
+				pool.applyForces(indices, count, h);
+			});
 
 			// integrate
-			for (UInt32 i = 0, count = m_bodies.count(); i < count; ++i)
+			forEachBodyGroup([&](Body *const *bodies, const UInt32 &count)
+			{
+				bodies[0]->m_integrate(bodies, count, h, gravity);
+
+				// contacts sharing a kinematic body run side by side, so its cached transforms are rebuilt here and not on first use
+				if (bodies[0]->m_kinematic)
+				{
+					for (UInt32 i = 0; i < count; ++i)
+					{
+						for (const Ref<Collider> &collider : bodies[i]->m_colliders)
+						{
+							collider.get().updateWorldTransform();
+						}
+					}
+				}
+			});
+			forEachParticleSystem([&, this](ParticleSystem &particles)
+			{
+				particles.integrate(h, gravity, *m_scheduler);
+			});
+
+			// clamp fast continuous bodies before they pass through
+			for (const UInt32 &i : m_continuousContacts)
 			{
-				m_bodies[i].integrate(h, gravity);
+				ContactConstraint::solveContinuous(m_contacts[i], m_contactContext);
 			}
 
 			// solve positions for each constraint
-			for (UInt32 i = 0, count = m_constraints.count(); i < count; ++i)
+			solveJoints([&](IConstraintPool &pool, const UInt32 *indices, const UInt32 &count)
 			{
-				m_constraints[i].solvePositions(hInvSq);
-			}
+				pool.solvePositions(indices, count, hInvSq);
+			});
 
-			
-			for (UInt32 i = 0; i < m_contactCount; ++i)
+			if (wideContacts)
 			{
-				m_contacts[i].solvePositions(hInvSq);
+				solveContactPositionsWide(hInvSq);
 			}
+			else
+			{
+				solveColored(m_contactColors, m_contactCount, [&, this](const UInt32 &i)
+				{
+					ContactConstraint::solvePositions(m_contacts[i], m_contactContext, hInvSq);
+				});
+			}
+			// after contacts, so articulated joints end every substep closed and contacts catch up in the next
+			solveArticulations(hInvSq);
+			forEachParticleSystem([&, this](ParticleSystem &particles)
+			{
+				particles.solvePositions(hInvSq, *m_scheduler);
+			});
 
 			// differentiate
-			for (UInt32 i = 0, count = m_bodies.count(); i < count; ++i)
+			forEachBodyGroup([&](Body *const *bodies, const UInt32 &count)
+			{
+				bodies[0]->m_differentiate(bodies, count, hInv);
+			});
+			forEachParticleSystem([&, this](ParticleSystem &particles)
 			{
-				m_bodies[i].differentiate(hInv);
+				particles.differentiate(hInv, *m_scheduler);
+			});
+
+			// what the solver moved in the last substep: the motion of the substep minus the motion integration gave it,
+			// preVelocity holds the integrated velocity by now so gravity and forces drop out
+			if (adaptiveSubSteps && s == subSteps - 1)
+			{
+				m_maxResidual = maxOverBodies([&](const Body &body)
+				{
+					const Vec3 moved = body.pose.transform(body.massPose.position) - body.prePose.transform(body.massPose.position);
+					const Vec3 turned = body.velocity.angular * h;
+					return (moved - body.preVelocity.linear * h).length() + (turned - body.preVelocity.angular * h).length() * body.m_ccdRadius;
+				});
 			}
 
 			// solve velocities for each constraint
+			solveColored(m_contactColors, m_contactCount, [&, this](const UInt32 &i)
+			{
+				ContactConstraint::solveVelocities(m_contacts[i], m_contactContext, h);
+			});
+
+			solveJoints([&](IConstraintPool &pool, const UInt32 *indices, const UInt32 &count)
+			{
+				pool.solveVelocities(indices, count, h, hInvSq);
+			});
+			forEachParticleSystem([&, this](ParticleSystem &particles)
+			{
+				particles.solveVelocities(h, *m_scheduler);
+			});
+		}
+
+		buildIslands();
+		if (sleepTime > 0)
+		{
+			forEachParticleSystem([&, this](ParticleSystem &particles)
+			{
+				particles.wakeBodies(sleepLinearVelocity * sleepLinearVelocity);
+			});
+		}
+		updateSleeping(deltaTime);
+
+		if (m_kinematicCount > 0)
+		{
+			for (UInt32 i = 0, count = m_bodies.count(); i < count; ++i)
+			{
+				m_bodies[i].reachTarget();
+			}
+		}
+
+		// the cache cannot see poses written between steps
+		cacheColliderTransforms(false);
+	}
+
+	/*
+	 * Largest measure over the awake bodies, each batch keeps its own maximum
+	 */
+	Float World::maxOverBodies(const function<Float(const Body &)> &measure)
+	{
+		const UInt32 count = m_bodies.count();
+		m_batchMax.assign((count + k_bodyBatch - 1) / k_bodyBatch, 0);
+		m_scheduler->parallelFor(count, k_bodyBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			Float result = 0;
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				const Body &body = m_bodies[i];
+				if (!body.m_sleeping)
+				{
+					result = Math::max(result, measure(body));
+				}
+			}
+			m_batchMax[begin / k_bodyBatch] = result;
+		});
+
+		Float result = 0;
+		for (const Float &batch : m_batchMax)
+		{
+			result = Math::max(result, batch);
+		}
+		return result;
+	}
+
+	/*
+	 * Motion is known ahead of the step. The residual is a correction per substep, it scales the count of the step
+	 * it was seen in so the whole step's correction is compared. Penetration is left over by the whole step and is
+	 * compared on its own, scaling the previous count would only feed back and lock at maxSubSteps.
+	 * Counts rise at once but fall by one per step, so a resting stack does not flip between counts.
+	 */
+	UInt32 World::chooseSubSteps(const Float &deltaTime)
+	{
+		assert(minSubSteps > 0 && minSubSteps <= maxSubSteps);
+		const Float motion = maxOverBodies([&](const Body &body)
+		{
+			if (body.m_ccdRadius <= 0)
+			{
+				return (Float)0;
+			}
+			const Float travel = (body.velocity.linear.length() + body.velocity.angular.length() * body.m_ccdRadius) * deltaTime;
+			return travel / (maxSubStepMotion * body.m_ccdRadius);
+		});
+
+		Float demand = Math::max(minSubSteps, motion);
+		demand = Math::max(demand, minSubSteps * m_maxPenetration / penetrationTolerance);
+		demand = Math::max(demand, m_subSteps * m_maxResidual / residualTolerance);
+
+		UInt32 subSteps = (UInt32)Math::ceil(Math::min(demand, maxSubSteps));
+		if (subSteps + 1 < m_subSteps)
+		{
+			subSteps = m_subSteps - 1;
+		}
+		return (UInt32)Math::clamp(subSteps, minSubSteps, maxSubSteps);
+	}
+
+	UInt32 World::advance(const Float &frameDeltaTime)
+	{
+		assert(fixedDeltaTime > 0);
+		m_accumulator += frameDeltaTime;
+
+		const UInt32 steps = (UInt32)Math::min(Math::floor(m_accumulator / fixedDeltaTime), (Float)maxCatchUpSteps);
+		for (UInt32 s = 0; s < steps; ++s)
+		{
+			// only the last step is blended
+			if (s == steps - 1)
+			{
+				m_scheduler->parallelFor(m_bodies.count(), k_bodyBatch, [this](const UInt32 &begin, const UInt32 &end)
+				{
+					for (UInt32 i = begin; i < end; ++i)
+					{
+						m_bodies[i].m_previousPose = m_bodies[i].pose;
+					}
+				});
+			}
+
+			simulate(fixedDeltaTime, fixedSubSteps);
+			m_accumulator -= fixedDeltaTime;
+		}
+
+		// behind by more than the cap allows, drop whole steps and keep the phase
+		if (m_accumulator >= fixedDeltaTime)
+		{
+			m_accumulator -= Math::floor(m_accumulator / fixedDeltaTime) * fixedDeltaTime;
+		}
+		return steps;
+	}
+
+	void World::interpolatePoses(const Ref<Body> *bodies, const UInt32 &count, Pose *outPoses) const
+	{
+		const Float alpha = interpolationAlpha();
+		m_scheduler->parallelFor(count, k_bodyBatch, [&](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				outPoses[i] = bodies[i].get().interpolatedPose(alpha);
+			}
+		});
+	}
+
+	/*
+	 * Runs over the awake bodies of each k_bodyBatch range, once per body type with all bodies of that type,
+	 * so their kernels see whole batches. Groups only depend on the range, not on the threads.
+	 */
+	void World::forEachBodyGroup(const function<void(Body *const *, const UInt32 &)> &run)
+	{
+		m_scheduler->parallelFor(m_bodies.count(), k_bodyBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			assert(end - begin <= k_bodyBatch);
+			Body *bodies[k_bodyBatch];
+			UInt32 count = 0;
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				Body &body = m_bodies[i];
+				if (!body.m_sleeping)
+				{
+					bodies[count++] = &body;
+				}
+			}
+
+			// bodies sharing the kernels of the first one move to the front of the rest
+			UInt32 first = 0;
+			while (first < count)
+			{
+				const auto kernel = bodies[first]->m_integrate;
+				UInt32 split = first + 1;
+				for (UInt32 i = split; i < count; ++i)
+				{
+					if (bodies[i]->m_integrate == kernel)
+					{
+						swap(bodies[i], bodies[split++]);
+					}
+				}
+
+				run(bodies + first, split - first);
+				first = split;
+			}
+		});
+	}
+
+	void World::cacheColliderTransforms(const bool &enable)
+	{
+		m_scheduler->parallelFor(m_colliders.count(), k_bodyBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				Collider &collider = m_colliders[i];
+				if (!enable)
+				{
+					collider.endStep();
+				}
+				else
+				{
+					collider.beginStep(collider.isStatic() ? nullptr : &m_bodies[collider.body().index()]);
+				}
+			}
+		});
+	}
+
+	/*
+	 * Orients every pair by collider id and sorts them, the broadphase reports them in hash map and tree order
+	 */
+	void World::sortPairs()
+	{
+		const UInt32 pairCount = m_pairs.size();
+		vector<pair<pair<UInt64, UInt64>, UInt32>> keys(pairCount);
+		for (UInt32 i = 0; i < pairCount; ++i)
+		{
+			auto &pair = m_pairs[i];
+			if (pair.first.id() > pair.second.id())
+			{
+				std::swap(pair.first, pair.second);
+			}
+			keys[i] = make_pair(make_pair(pair.first.id(), pair.second.id()), i);
+		}
+		std::sort(keys.begin(), keys.end());
+
+		vector<pair<Ref<Collider>, Ref<Collider>>> sorted;
+		sorted.reserve(pairCount);
+		for (const auto &key : keys)
+		{
+			sorted.push_back(m_pairs[key.second]);
+		}
+		m_pairs.swap(sorted);
+	}
+
+	/*
+	 * Lists the joints pool after pool, so the solver mostly sees long runs of one type.
+	 * Also resolves their bodies, which stay put until the step ends.
+	 */
+	void World::gatherJoints()
+	{
+		m_jointPools.clear();
+		m_jointIndices.clear();
+		for (UInt32 p = 0, poolCount = m_constraintPools.size(); p < poolCount; ++p)
+		{
+			IConstraintPool *pool = m_constraintPools[p];
+			if (pool == nullptr)
+			{
+				continue;
+			}
+
+			for (UInt32 i = 0, count = pool->count(); i < count; ++i)
+			{
+				pool->constraint(i).resolve(m_bodies);
+			}
+
+			if (deterministic)
+			{
+				pool->forEachOrdered([&, this](const UInt32 &index)
+				{
+					m_jointPools.push_back(p);
+					m_jointIndices.push_back(index);
+				});
+				continue;
+			}
+
+			for (UInt32 i = 0, count = pool->count(); i < count; ++i)
+			{
+				m_jointPools.push_back(p);
+				m_jointIndices.push_back(i);
+			}
+		}
+	}
+
+	/*
+	 * Colors the gathered joints and copies them out color after color, joints of one pool stay adjacent within a color
+	 */
+	void World::colorJoints()
+	{
+		const UInt32 count = m_jointIndices.size();
+		m_jointColors.build(m_bodies.count(), count, [this](const UInt32 &i)
+		{
+			const Constraint &joint = m_constraintPools[m_jointPools[i]]->constraint(m_jointIndices[i]);
+			return make_pair(solvedBody(joint.bodyA), solvedBody(joint.bodyB));
+		});
+
+		m_coloredJointPools.resize(count);
+		m_coloredJointIndices.resize(count);
+		UInt32 cursor = 0;
+		for (UInt32 c = 0, colorCount = m_jointColors.count(); c < colorCount; ++c)
+		{
+			for (UInt32 i = 0, size = m_jointColors.size(c); i < size; ++i)
+			{
+				const UInt32 joint = m_jointColors.constraint(c, i);
+				m_coloredJointPools[cursor] = m_jointPools[joint];
+				m_coloredJointIndices[cursor] = m_jointIndices[joint];
+				cursor++;
+			}
+		}
+	}
+
+	/*
+	 * Bounds of a collider grown by how far its body may move during the step.
+	 * The reach is doubled to leave room for velocity picked up from other constraints.
+	 */
+	inline Bounds reachBounds(const Collider &collider, const Body *body, const Float &deltaTime, const Float &gravitySpeed)
+	{
+		Bounds bounds = collider.bounds();
+		if (body != nullptr)
+		{
+			const Float speed = body->velocity.linear.length() + gravitySpeed + body->velocity.angular.length() * bounds.extents().length();
+			bounds.expand(2 * speed * deltaTime);
+		}
+		return bounds;
+	}
+
+	/*
+	 * Runs the narrowphase on every pair in parallel, each pair writes only its own contact slot.
+	 * With cullUnreachablePairs, pairs that neither collide nor can reach each other this step are then
+	 * compacted away in pair order, so the contact list does not depend on the thread count.
+	 */
+	void World::collectContacts(const Float &deltaTime)
+	{
+		const UInt32 pairCount = m_pairs.size();
+		if (m_contacts.size() < pairCount)
+		{
+			m_contacts.resize(pairCount);
+		}
+		m_pairKept.resize(pairCount);
+		m_contactContext = ContactConstraint::Context{&m_bodies, &m_colliders, gravity};
+
+		const Float gravitySpeed = gravity.length() * deltaTime;
+		m_scheduler->parallelFor(pairCount, k_pairBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				ContactConstraint::Data &contact = m_contacts[i];
+				contact.init(i, m_pairs[i].first, m_pairs[i].second, m_narrowphase);
+				ContactConstraint::update(contact, m_contactContext);
+
+				m_pairKept[i] = contact.colliding || !cullUnreachablePairs || reachBounds(m_contactContext.collider(contact.colliderA), contact.bodyA != NOT_FOUND ? &m_bodies[contact.bodyA] : nullptr, deltaTime, gravitySpeed)
+					.intersects(reachBounds(m_contactContext.collider(contact.colliderB), contact.bodyB != NOT_FOUND ? &m_bodies[contact.bodyB] : nullptr, deltaTime, gravitySpeed));
+			}
+		});
+
+		m_contactCount = 0;
+		m_maxPenetration = 0;
+		m_continuousContacts.clear();
+		for (UInt32 i = 0; i < pairCount; ++i)
+		{
+			if (m_pairKept[i] == 0)
+			{
+				continue;
+			}
+
+			if (i != m_contactCount)
+			{
+				m_contacts[m_contactCount] = m_contacts[i];
+			}
+
+			if (m_contacts[m_contactCount].colliding)
+			{
+				m_maxPenetration = Math::max(m_maxPenetration, m_contacts[m_contactCount].contact.depth);
+			}
+
+			if (ContactConstraint::isContinuous(m_contacts[m_contactCount], m_contactContext))
+			{
+				m_continuousContacts.push_back(m_contactCount);
+			}
+			m_contactCount++;
+		}
+	}
+
+	/*
+	 * Colors run one after another, constraints within a color are split across the thread pool.
+	 * Small worlds keep the serial creation order so they behave the same on any machine.
+	 */
+	void World::solveColored(const ConstraintColoring &coloring, const UInt32 &count, const function<void(const UInt32 &)> &solve)
+	{
+		if (!deterministic && (count < parallelThreshold || m_scheduler->threadCount() == 1))
+		{
+			for (UInt32 i = 0; i < count; ++i)
+			{
+				solve(i);
+			}
+			return;
+		}
+
+		for (UInt32 c = 0, colorCount = coloring.count(); c < colorCount; ++c)
+		{
+			const UInt32 size = coloring.size(c);
+			if (coloring.isSerial(c) || size < k_minParallelBatch * 2)
+			{
+				for (UInt32 i = 0; i < size; ++i)
+				{
+					solve(coloring.constraint(c, i));
+				}
+				continue;
+			}
+
+			m_scheduler->parallelFor(size, k_minParallelBatch, [&](const UInt32 &begin, const UInt32 &end)
+			{
+				for (UInt32 i = begin; i < end; ++i)
+				{
+					solve(coloring.constraint(c, i));
+				}
+			});
+		}
+	}
+
+	/*
+	 * Like solveColored, except that even small worlds go by color since the lanes of a batch must not share bodies.
+	 * Parallel batches are a multiple of the lane count.
+	 */
+	void World::solveContactPositionsWide(const Float &dtInvSq)
+	{
+		for (UInt32 c = 0, colorCount = m_contactColors.count(); c < colorCount; ++c)
+		{
+			const UInt32 size = m_contactColors.size(c);
+			const UInt32 *indices = m_contactColors.constraints(c);
+			if (m_contactColors.isSerial(c))
+			{
+				for (UInt32 i = 0; i < size; ++i)
+				{
+					ContactConstraint::solvePositions(m_contacts[indices[i]], m_contactContext, dtInvSq);
+				}
+				continue;
+			}
+
+			if (size < k_minParallelBatch * 2 || m_scheduler->threadCount() == 1)
+			{
+				WideContactSolver::solvePositions(m_contacts.data(), indices, size, m_contactContext, dtInvSq);
+				continue;
+			}
+
+			m_scheduler->parallelFor(size, k_minParallelBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+			{
+				WideContactSolver::solvePositions(m_contacts.data(), indices + begin, end - begin, m_contactContext, dtInvSq);
+			});
+		}
+	}
+
+	/*
+	 * Same fallbacks as solveColored, but hands each pool a whole run of its joints at once
+	 */
+	void World::solveJoints(const JointRunCallback &solve)
+	{
+		const UInt32 count = m_jointIndices.size();
+		if (!deterministic && (count < parallelThreshold || m_scheduler->threadCount() == 1))
+		{
+			solveJointRuns(m_jointPools.data(), m_jointIndices.data(), count, solve);
+			return;
+		}
+
+		UInt32 offset = 0;
+		for (UInt32 c = 0, colorCount = m_jointColors.count(); c < colorCount; ++c)
+		{
+			const UInt32 size = m_jointColors.size(c);
+			const UInt32 *pools = m_coloredJointPools.data() + offset;
+			const UInt32 *indices = m_coloredJointIndices.data() + offset;
+			offset += size;
+
+			if (m_jointColors.isSerial(c) || size < k_minParallelBatch * 2)
+			{
+				solveJointRuns(pools, indices, size, solve);
+				continue;
+			}
+
+			m_scheduler->parallelFor(size, k_minParallelBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+			{
+				solveJointRuns(pools + begin, indices + begin, end - begin, solve);
+			});
+		}
+	}
+
+	/*
+	 * Articulations share no links, each is one serial solve
+	 */
+	void World::solveArticulations(const Float &dtInvSq)
+	{
+		m_scheduler->parallelFor(m_articulations.count(), 1, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				m_articulations[i].solvePositions(dtInvSq);
+			}
+		});
+	}
+
+	void World::solveJointRuns(const UInt32 *pools, const UInt32 *indices, const UInt32 &count, const JointRunCallback &solve)
+	{
+		UInt32 begin = 0;
+		while (begin < count)
+		{
+			UInt32 end = begin + 1;
+			while (end < count && pools[end] == pools[begin])
+			{
+				end++;
+			}
+
+			solve(*m_constraintPools[pools[begin]], indices + begin, end - begin);
+			begin = end;
+		}
+	}
+
+	void World::buildIslands()
+	{
+		m_islands.reset(m_bodies.count());
+		for (UInt32 i = 0, count = m_jointIndices.size(); i < count; ++i)
+		{
+			const Constraint &constraint = m_constraintPools[m_jointPools[i]]->constraint(m_jointIndices[i]);
+			m_islands.addConstraint(i, solvedBody(constraint.bodyA), solvedBody(constraint.bodyB));
+		}
+
+		for (UInt32 i = 0, count = m_articulations.count(); i < count; ++i)
+		{
+			const Articulation &articulation = m_articulations[i];
+			for (UInt32 link = 1; link < articulation.count(); ++link)
+			{
+				m_islands.connect(articulation.body(articulation.parent(link)), articulation.body(link));
+			}
+		}
+
+		for (UInt32 i = 0; i < m_contactCount; ++i)
+		{
+			const ContactConstraint::Data &contact = m_contacts[i];
+			if (contact.colliding)
+			{
+				m_islands.addContact(i, solvedBody(contact.bodyA), solvedBody(contact.bodyB));
+			}
+		}
+
+		m_islands.build();
+	}
+
+	/*
+	 * An island sleeps once all of its bodies have rested long enough, otherwise all of it wakes.
+	 * Sleeping bodies touching or jointed to an awake body share its island, so they wake with it.
+	 */
+	void World::updateSleeping(const Float &deltaTime)
+	{
+		if (sleepTime <= 0)
+		{
+			return;
+		}
+
+		const Float linearSq = sleepLinearVelocity * sleepLinearVelocity;
+		const Float angularSq = sleepAngularVelocity * sleepAngularVelocity;
+		m_scheduler->parallelFor(m_bodies.count(), k_bodyBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 i = begin; i < end; ++i)
+			{
+				Body &body = m_bodies[i];
+				if (body.m_sleeping)
+				{
+					continue;
+				}
+
+				// kinematic bodies keep their velocity, so only standing still counts as rest
+				const bool slow = body.m_kinematic ?
+					body.velocity.linear.lengthSq() == 0 && body.velocity.angular.lengthSq() == 0 :
+					body.velocity.linear.lengthSq() < linearSq && body.velocity.angular.lengthSq() < angularSq;
+				if (slow)
+				{
+					body.m_sleepTimer += deltaTime;
+				}
+				else
+				{
+					body.m_sleepTimer = 0;
+				}
+			}
+		});
+
+		// kinematic bodies keep islands apart, instead a moving one wakes the bodies it touches or holds
+		if (m_kinematicCount > 0)
+		{
+			const auto wakeByKinematic = [&, this](const UInt32 &kinematic, const UInt32 &other)
+			{
+				if (kinematic == NOT_FOUND || other == NOT_FOUND || !m_bodies[kinematic].m_kinematic)
+				{
+					return;
+				}
+
+				const Body &body = m_bodies[kinematic];
+				const bool moving = !body.m_sleeping && (body.velocity.linear.lengthSq() >= linearSq || body.velocity.angular.lengthSq() >= angularSq);
+				if (moving && m_bodies[other].m_sleeping)
+				{
+					m_bodies[other].wake();
+				}
+			};
+
 			for (UInt32 i = 0; i < m_contactCount; ++i)
 			{
-				m_contacts[i].solveVelocities(h, hInvSq);
+				const ContactConstraint::Data &contact = m_contacts[i];
+				if (contact.colliding)
+				{
+					wakeByKinematic(contact.bodyA, contact.bodyB);
+					wakeByKinematic(contact.bodyB, contact.bodyA);
+				}
 			}
 
-			for (UInt32 i = 0, count = m_constraints.count(); i < count; ++i)
+			for (UInt32 i = 0, count = m_jointIndices.size(); i < count; ++i)
 			{
-				m_constraints[i].solveVelocities(h, hInvSq);
+				const Constraint &constraint = m_constraintPools[m_jointPools[i]]->constraint(m_jointIndices[i]);
+				const UInt32 bodyA = constraint.bodyA.valid() ? (UInt32)constraint.bodyA.index() : NOT_FOUND;
+				const UInt32 bodyB = constraint.bodyB.valid() ? (UInt32)constraint.bodyB.index() : NOT_FOUND;
+				wakeByKinematic(bodyA, bodyB);
+				wakeByKinematic(bodyB, bodyA);
 			}
 		}
+
+		// islands share no bodies
+		m_scheduler->parallelFor(m_islands.count(), k_minParallelBatch, [&, this](const UInt32 &begin, const UInt32 &end)
+		{
+			for (UInt32 island = begin; island < end; ++island)
+			{
+				const UInt32 count = m_islands.bodyCount(island);
+				bool resting = true;
+				for (UInt32 i = 0; i < count && resting; ++i)
+				{
+					resting = m_bodies[m_islands.body(island, i)].m_sleepTimer >= sleepTime;
+				}
+
+				for (UInt32 i = 0; i < count; ++i)
+				{
+					Body &body = m_bodies[m_islands.body(island, i)];
+					if (resting && !body.m_sleeping)
+					{
+						body.sleep();
+					}
+					else if (!resting && body.m_sleeping)
+					{
+						body.wake();
+					}
+				}
+			}
+		});
 	}
 
 #pragma endregion // Simulation
@@ -6,6 +6,9 @@
 #include "collision/collider/SphereCollider.h"
 #include "collision/collider/BoxCollider.h"
 #include "collision/collider/CapsuleCollider.h"
+#include "collision/collider/ConvexHullCollider.h"
+#include "collision/collider/TriangleMeshCollider.h"
+#include "collision/collider/HeightfieldCollider.h"
 #include <unordered_set>
 #include "data/Store.h"
 #include "data/IdPair.h"
@@ -14,6 +17,14 @@
 #include "collision/narrowphase/RaycastResult.h"
 #include "collision/narrowphase/CollisionResult.h"
 #include "constraints/Constraint.h"
+#include "constraints/ConstraintPool.h"
+#include "constraints/ContactConstraint.h"
+#include "Islands.h"
+#include "ConstraintColoring.h"
+#include "ParticleSystem.h"
+#include "Articulation.h"
+#include "tasks/JobSystem.h"
+#include "tasks/TaskGraph.h"
 
 using namespace std;
 
@@ -22,32 +33,190 @@ namespace Positional
 	typedef function<void(const RaycastResult &)> RaycastCallback;
 	typedef function<void(const CollisionResult &)> CollisionCallback;
 	typedef function<void(const Ref<Body> &)> BodyCallback;
+	// a run of joints from one pool, given by store index
+	typedef function<void(IConstraintPool &, const UInt32 *, const UInt32 &)> JointRunCallback;
 
 	class World
 	{
 	private:
 		Store<Body> m_bodies;
+		// kinematic bodies among them, their targets are only looked for when there are any
+		UInt32 m_kinematicCount;
 		Store<Collider> m_colliders;
-		Store<Constraint> m_constraints;
+		// one pool per joint data type, indexed by ConstraintTypes::id and null until used
+		vector<IConstraintPool *> m_constraintPools;
+		Store<Articulation> m_articulations;
 		Collision::IBroadphase *m_broadphase;
 		Collision::INarrowphase *m_narrowphase;
 
-		unordered_set<IdPair<UInt64>, IdPair<UInt64>::SYM_HASH, IdPair<UInt64>::SYM_EQ> m_ignoreBodies;
+		// one entry per joint ignoring collisions, static colliders use k_staticKey
+		unordered_multiset<IdPair<UInt64>, IdPair<UInt64>::SYM_HASH, IdPair<UInt64>::SYM_EQ> m_ignoreBodies;
 		unordered_set<IdPair<UInt64>, IdPair<UInt64>::SYM_HASH, IdPair<UInt64>::SYM_EQ> m_ignoreColliders;
+		static const UInt64 k_staticKey = 0xffffffffffffffffull;
 
-		vector<Constraint> m_contacts;
+		static inline UInt64 bodyKey(const Ref<Body> &body) { return body.valid() ? body.id() : k_staticKey; }
+		bool isIgnored(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB) const;
+		void releaseIgnore(const Constraint &constraint);
+		void ignoreLinks(const Articulation &articulation, const bool &ignore);
+
+		// broadphase pairs of this step, contact i starts out as pair i before compaction
+		vector<pair<Ref<Collider>, Ref<Collider>>> m_pairs;
+		vector<UInt8> m_pairKept;
+
+		// pooled across steps, only the first m_contactCount are live
+		vector<ContactConstraint::Data> m_contacts;
 		UInt32 m_contactCount;
+		ContactConstraint::Context m_contactContext;
+		// contacts with a continuous body
+		vector<UInt32> m_continuousContacts;
+
+		Islands m_islands;
+		// stepped in store order, they collide with colliders but not with each other
+		Store<ParticleSystem> m_particleSystems;
+
+		// substeps of the last step and the errors it left, they drive adaptiveSubSteps
+		UInt32 m_subSteps;
+		Float m_maxPenetration;
+		Float m_maxResidual;
+		// one value per k_bodyBatch bodies
+		vector<Float> m_batchMax;
+
+		// time handed to advance that no fixed step has consumed yet
+		Float m_accumulator;
+
+		// constraints per parallel job, smaller colors are solved on the calling thread
+		static const UInt32 k_minParallelBatch = 16;
+		static const UInt32 k_bodyBatch = 64;
+		static const UInt32 k_pairBatch = 32;
+
+		ITaskScheduler *m_scheduler;
+		bool m_ownsScheduler;
+		ConstraintColoring m_jointColors;
+		ConstraintColoring m_contactColors;
+		// colors joints and contacts side by side
+		TaskGraph m_colorGraph;
+
+		World(ITaskScheduler *scheduler, const bool &ownsScheduler);
+
+		// joints of this step as pool and store index, pool after pool, creation order when deterministic
+		vector<UInt32> m_jointPools;
+		vector<UInt32> m_jointIndices;
+		// the same joints color after color
+		vector<UInt32> m_coloredJointPools;
+		vector<UInt32> m_coloredJointIndices;
+
+		template <class ConstraintT, class DataT>
+		TypedConstraintPool<DataT> &constraintPool()
+		{
+			const UInt32 id = ConstraintTypes::id<DataT>();
+			if (m_constraintPools.size() <= id)
+			{
+				m_constraintPools.resize(id + 1, nullptr);
+			}
+			if (m_constraintPools[id] == nullptr)
+			{
+				m_constraintPools[id] = new ConstraintPool<ConstraintT, DataT>();
+			}
+			return *static_cast<TypedConstraintPool<DataT> *>(m_constraintPools[id]);
+		}
+
+		void sortPairs();
+		void gatherJoints();
+		void colorJoints();
+		void cacheColliderTransforms(const bool &enable);
+		void collectContacts(const Float &deltaTime);
+		void buildIslands();
+		void solveColored(const ConstraintColoring &coloring, const UInt32 &count, const function<void(const UInt32 &)> &solve);
+		void solveContactPositionsWide(const Float &dtInvSq);
+		void solveJoints(const JointRunCallback &solve);
+		void solveJointRuns(const UInt32 *pools, const UInt32 *indices, const UInt32 &count, const JointRunCallback &solve);
+		void solveArticulations(const Float &dtInvSq);
+		void forEachParticleSystem(const function<void(ParticleSystem &)> &callback);
+		void updateSleeping(const Float &deltaTime);
+		Float maxOverBodies(const function<Float(const Body &)> &measure);
+		void forEachBodyGroup(const function<void(Body *const *, const UInt32 &)> &run);
+		UInt32 chooseSubSteps(const Float &deltaTime);
 
 		Ref<Collider> addCollider(const Ref<Body> &body, const Collider &collider);
+		void addToBroadphase(const Ref<Collider> &collider);
+		void removeFromBroadphase(const Ref<Collider> &collider);
+
+		// store index of a body the solver moves, NOT_FOUND for static and kinematic bodies
+		inline UInt32 solvedBody(const UInt32 &index)
+		{
+			return index != NOT_FOUND && !m_bodies[index].m_kinematic ? index : NOT_FOUND;
+		}
+		inline UInt32 solvedBody(const Ref<Body> &body)
+		{
+			return body.valid() ? solvedBody((UInt32)body.index()) : NOT_FOUND;
+		}
 	public:
 		Vec3 gravity;
 
+		// bodies slower than these for sleepTime seconds may sleep, whole islands sleep together
+		Float sleepLinearVelocity;
+		Float sleepAngularVelocity;
+		// zero or less disables sleeping, which is the default. Around 0.5 suits most scenes.
+		Float sleepTime;
+
+		// fewer constraints than this are solved on the calling thread in creation order
+		UInt32 parallelThreshold;
+
+		/*
+		 * Drops pairs that do not collide at the start of a step and whose colliders cannot reach each other
+		 * at twice their current speed plus gravity. Much cheaper for scenes full of padded proxies, but a body
+		 * struck hard during the step can outrun the estimate and sink into or pass through a dropped pair.
+		 */
+		bool cullUnreachablePairs;
+
+		/*
+		 * Orders pairs and joints by id and always solves by color, so a step gives bit identical results
+		 * for any thread count and store layout. Costs a sort of the pairs per step.
+		 */
+		bool deterministic;
+
+		/*
+		 * Solves contact positions with WideContactSolver, Wide::width contacts of a color at a time.
+		 * Contacts are then always solved by color, results match the scalar solver up to rounding.
+		 */
+		bool wideContacts;
+
+		/*
+		 * Ignores the substeps passed to simulate and picks between minSubSteps and maxSubSteps every step.
+		 * More are taken when a body moves far for its size, contacts penetrate deeply or the last step still
+		 * had to correct a lot, quiet steps drop back by one substep per step.
+		 */
+		bool adaptiveSubSteps;
+		UInt32 minSubSteps;
+		UInt32 maxSubSteps;
+		// travel per substep as a fraction of a body's ccdRadius
+		Float maxSubStepMotion;
+		// contact depth and position correction in the last substep that one more substep is taken for
+		Float penetrationTolerance;
+		Float residualTolerance;
+
+		/*
+		 * Runs a JobSystem with one worker less than the hardware threads, the calling thread makes up the rest
+		 */
 		World();
+		World(const UInt32 &workerCount);
+
+		/*
+		 * Runs all parallel work on an existing scheduler, it has to outlive the world
+		 */
+		World(ITaskScheduler &scheduler);
 		~World();
 
+		/*
+		 * T is RigidBody, Particle or KinematicBody
+		 */
 		template <class T>
 		Ref<Body> createBody(const Vec3 &position, const Quat &rotation)
 		{
+			if (T::isKinematic())
+			{
+				m_kinematicCount++;
+			}
 			return m_bodies.store(Body::create<T>(this, position, rotation));
 		}
 		void destroyBody(Ref<Body> ref);
@@ -62,26 +231,114 @@ namespace Positional
 		void destroyCollider(Ref<Collider> ref);
 
 		template <class ConstraintT, class DataT, typename... DataArgs>
-		Ref<Constraint> createConstraint(const Ref<Body> &bodyA, const Ref<Body> &bodyB, const bool &ignoreCollisions, DataArgs &&...dataArgs)
+		Ref<TypedConstraint<DataT>> createConstraint(const Ref<Body> &bodyA, const Ref<Body> &bodyB, const bool &ignoreCollisions, DataArgs &&...dataArgs)
 		{
-			Constraint joint = Constraint::create<ConstraintT, DataT>();
-			joint.init<DataT>(bodyA, bodyB, ignoreCollisions, dataArgs...);
-			return m_constraints.store(joint);
+			TypedConstraint<DataT> joint;
+			joint.template init<DataT>(bodyA, bodyB, ignoreCollisions, dataArgs...);
+			if (ignoreCollisions)
+			{
+				joint.ignoreKey = IdPair<UInt64>(bodyKey(bodyA), bodyKey(bodyB));
+				m_ignoreBodies.insert(joint.ignoreKey);
+			}
+			return constraintPool<ConstraintT, DataT>().store(joint);
 		}
 
-		void destroyConstraint(Ref<Constraint> ref)
+		/*
+		 * Handles that are expired or belong to another world are ignored
+		 */
+		template <class DataT>
+		void destroyConstraint(Ref<TypedConstraint<DataT>> ref)
 		{
-			m_constraints.erase(ref);
+			const UInt32 id = ConstraintTypes::id<DataT>();
+			if (!ref.valid() || id >= m_constraintPools.size() || m_constraintPools[id] == nullptr)
+			{
+				return;
+			}
+
+			// copied before erasing, the last constraint of the pool moves into its slot
+			const TypedConstraint<DataT> constraint = ref.get();
+			if (static_cast<TypedConstraintPool<DataT> *>(m_constraintPools[id])->erase(ref))
+			{
+				releaseIgnore(constraint);
+			}
 		}
 
+		/*
+		 * Stores a copy of the articulation, its links keep out of contact with their parents when ignoring collisions.
+		 * Destroying a link's body destroys the articulation. A body may be a link of one articulation only.
+		 */
+		Ref<Articulation> createArticulation(const Articulation &articulation, const bool &ignoreCollisions = true);
+		void destroyArticulation(Ref<Articulation> ref);
+
+		/*
+		 * Skips or restores contacts between two colliders, independent of joints
+		 */
+		void ignoreCollisions(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB, const bool &ignore = true);
+		bool ignoresCollisions(const Ref<Collider> &colliderA, const Ref<Collider> &colliderB) const;
+
 		void raycast(const Ray &ray, const UInt32 &mask, const Float &maxDistance, const RaycastCallback &callback) const;
 		void forEachBody(const BodyCallback &callback);
 		void forEachBoundsNode(const function <void(const Bounds &bounds)> &callback) const;
 		void forEachBroadPair(const Collision::OverlapCallback &callback) const;
 		void forEachCollision(const CollisionCallback &callback) const;
 
+		/*
+		 * Hash of every body pose and velocity in creation order, equal across runs when the simulation is deterministic
+		 */
+		UInt64 stateHash() const;
+
+		/*
+		 * Particles stepped with the bodies, see ParticleSystem. Each system is either fluid or not for its lifetime,
+		 * particles of different systems do not collide with each other.
+		 */
+		Ref<ParticleSystem> createParticleSystem(const bool &fluid = false);
+		void destroyParticleSystem(Ref<ParticleSystem> ref);
+		inline UInt32 particleSystemCount() const { return m_particleSystems.count(); }
+
+		/*
+		 * Islands from the last step
+		 */
+		const Islands &islands() const { return m_islands; }
+
+		/*
+		 * Solver batches from the last step, constraints of one color run in parallel
+		 */
+		const ConstraintColoring &jointColors() const { return m_jointColors; }
+		const ConstraintColoring &contactColors() const { return m_contactColors; }
+		UInt32 threadCount() const { return m_scheduler->threadCount(); }
+
 		void updateBroadphase();
 		void simulate(const Float &deltaTime, const UInt32 &subSteps);
+
+		/*
+		 * Substeps the last step ran with
+		 */
+		inline UInt32 subStepCount() const { return m_subSteps; }
+
+		/*
+		 * Step length and substeps of advance
+		 */
+		Float fixedDeltaTime;
+		UInt32 fixedSubSteps;
+
+		// most steps one advance runs to catch up, time beyond that is dropped so slow frames cannot snowball
+		UInt32 maxCatchUpSteps;
+
+		/*
+		 * Adds a frame's time and runs whole fixed steps while enough has accumulated, returns how many ran.
+		 * The remainder carries over to the next frame, render between the last two steps with interpolatePoses.
+		 */
+		UInt32 advance(const Float &frameDeltaTime);
+
+		/*
+		 * How far the leftover time reaches into the next fixed step, from 0 to 1
+		 */
+		inline Float interpolationAlpha() const { return m_accumulator / fixedDeltaTime; }
+
+		/*
+		 * Writes the pose of bodies[i] at interpolationAlpha between the last two fixed steps to outPoses[i]
+		 */
+		void interpolatePoses(const Ref<Body> *bodies, const UInt32 &count, Pose *outPoses) const;
 	};
 }
 #endif // WORLD_H
\ No newline at end of file
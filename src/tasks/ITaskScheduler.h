@@ -0,0 +1,35 @@
+/*
+ * Interface for running simulation work in parallel, implement it to share an engine's existing worker threads
+ */
+#ifndef ITASK_SCHEDULER_H
+#define ITASK_SCHEDULER_H
+
+#include "math/Math.h"
+#include <functional>
+
+using namespace std;
+
+namespace Positional
+{
+	// called with a half open range [begin, end)
+	typedef function<void(const UInt32 &, const UInt32 &)> RangeCallback;
+
+	class ITaskScheduler
+	{
+	public:
+		virtual ~ITaskScheduler() {};
+
+		/*
+		 * Threads that may run batches at the same time, including the calling thread
+		 */
+		virtual UInt32 threadCount() const = 0;
+
+		/*
+		 * Runs task over [0, count) in batches of at most batchSize and blocks until all of them ran.
+		 * Batches start at multiples of batchSize so callers may keep per batch results.
+		 * They may run on any thread in any order, and may themselves call parallelFor.
+		 */
+		virtual void parallelFor(const UInt32 &count, const UInt32 &batchSize, const RangeCallback &task) = 0;
+	};
+}
+#endif // ITASK_SCHEDULER_H
@@ -0,0 +1,172 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace Positional
+{
+	// queue of the current thread, only meaningful for the system that started it
+	thread_local const JobSystem *t_system = nullptr;
+	thread_local UInt32 t_queue = 0;
+
+	JobSystem::JobSystem(const UInt32 &workerCount) :
+		m_queued(0),
+		m_stop(false)
+	{
+		for (UInt32 i = 0; i <= workerCount; ++i)
+		{
+			m_queues.push_back(make_unique<Queue>());
+		}
+
+		m_workers.reserve(workerCount);
+		for (UInt32 i = 0; i < workerCount; ++i)
+		{
+			m_workers.push_back(thread(&JobSystem::work, this, i + 1));
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			lock_guard<mutex> lock(m_sleepMutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+
+		for (thread &worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+#pragma region ITaskScheduler Interface
+	void JobSystem::parallelFor(const UInt32 &count, const UInt32 &batchSize, const RangeCallback &task)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		const UInt32 batch = std::max(batchSize, 1u);
+		if (m_workers.empty() || count <= batch)
+		{
+			for (UInt32 begin = 0; begin < count; begin += batch)
+			{
+				task(begin, std::min(begin + batch, count));
+			}
+			return;
+		}
+
+		const UInt32 queue = queueIndex();
+		atomic<UInt32> pending(count);
+		execute(queue, Job{&task, 0, count, batch, &pending});
+
+		// help out until every range ran, this also runs ranges of other loops when nested
+		while (pending.load(memory_order_acquire) > 0)
+		{
+			Job job;
+			if (pop(queue, job) || steal(queue, job))
+			{
+				execute(queue, job);
+			}
+			else
+			{
+				this_thread::yield();
+			}
+		}
+	}
+#pragma endregion ITaskScheduler Interface
+
+#pragma region Queues
+	UInt32 JobSystem::queueIndex() const
+	{
+		return t_system == this ? t_queue : 0;
+	}
+
+	void JobSystem::push(const UInt32 &queue, const Job &job)
+	{
+		{
+			lock_guard<mutex> lock(m_queues[queue]->lock);
+			m_queues[queue]->jobs.push_back(job);
+		}
+		m_queued.fetch_add(1, memory_order_release);
+
+		// taking the lock orders this with a worker checking m_queued before it waits
+		{
+			lock_guard<mutex> lock(m_sleepMutex);
+		}
+		m_wake.notify_one();
+	}
+
+	bool JobSystem::pop(const UInt32 &queue, Job &outJob)
+	{
+		Queue &q = *m_queues[queue];
+		lock_guard<mutex> lock(q.lock);
+		if (q.jobs.empty())
+		{
+			return false;
+		}
+
+		outJob = q.jobs.back();
+		q.jobs.pop_back();
+		m_queued.fetch_sub(1, memory_order_relaxed);
+		return true;
+	}
+
+	bool JobSystem::steal(const UInt32 &thief, Job &outJob)
+	{
+		const UInt32 queueCount = m_queues.size();
+		for (UInt32 i = 1; i < queueCount; ++i)
+		{
+			Queue &q = *m_queues[(thief + i) % queueCount];
+			lock_guard<mutex> lock(q.lock);
+			if (!q.jobs.empty())
+			{
+				outJob = q.jobs.front();
+				q.jobs.pop_front();
+				m_queued.fetch_sub(1, memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/*
+	 * Keeps the first batches and hands the upper half of the range to thieves until one batch is left
+	 */
+	void JobSystem::execute(const UInt32 &queue, Job job)
+	{
+		while (job.end - job.begin > job.batchSize)
+		{
+			const UInt32 batches = (job.end - job.begin + job.batchSize - 1) / job.batchSize;
+			const UInt32 mid = job.begin + (batches / 2) * job.batchSize;
+			push(queue, Job{job.task, mid, job.end, job.batchSize, job.pending});
+			job.end = mid;
+		}
+
+		(*job.task)(job.begin, job.end);
+		job.pending->fetch_sub(job.end - job.begin, memory_order_acq_rel);
+	}
+
+	void JobSystem::work(const UInt32 &queue)
+	{
+		t_system = this;
+		t_queue = queue;
+
+		while (true)
+		{
+			Job job;
+			if (pop(queue, job) || steal(queue, job))
+			{
+				execute(queue, job);
+				continue;
+			}
+
+			unique_lock<mutex> lock(m_sleepMutex);
+			m_wake.wait(lock, [this] { return m_stop || m_queued.load(memory_order_acquire) > 0; });
+			if (m_stop)
+			{
+				return;
+			}
+		}
+	}
+#pragma endregion // Queues
+}
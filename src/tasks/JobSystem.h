@@ -0,0 +1,72 @@
+/*
+ * Work stealing scheduler. Every thread owns a deque of ranges, it splits and pops from the back
+ * while idle threads steal the larger ranges from the front.
+ */
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "ITaskScheduler.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+namespace Positional
+{
+	class JobSystem : public ITaskScheduler
+	{
+	private:
+		struct Job
+		{
+			const RangeCallback *task;
+			UInt32 begin;
+			UInt32 end;
+			UInt32 batchSize;
+			// items of the parallelFor that have not run yet
+			atomic<UInt32> *pending;
+		};
+
+		struct Queue
+		{
+			mutex lock;
+			deque<Job> jobs;
+		};
+
+		vector<thread> m_workers;
+		// queue 0 belongs to threads outside the pool
+		vector<unique_ptr<Queue>> m_queues;
+
+		mutex m_sleepMutex;
+		condition_variable m_wake;
+		atomic<UInt32> m_queued;
+		bool m_stop;
+
+		UInt32 queueIndex() const;
+		void push(const UInt32 &queue, const Job &job);
+		bool pop(const UInt32 &queue, Job &outJob);
+		bool steal(const UInt32 &thief, Job &outJob);
+		void execute(const UInt32 &queue, Job job);
+		void work(const UInt32 &queue);
+
+	public:
+		/*
+		 * Zero workers runs everything on the calling thread
+		 */
+		JobSystem(const UInt32 &workerCount);
+		~JobSystem();
+
+		JobSystem(const JobSystem &) = delete;
+		JobSystem &operator=(const JobSystem &) = delete;
+
+#pragma region ITaskScheduler Interface
+		virtual UInt32 threadCount() const override { return m_workers.size() + 1; }
+		virtual void parallelFor(const UInt32 &count, const UInt32 &batchSize, const RangeCallback &task) override;
+#pragma endregion ITaskScheduler Interface
+	};
+}
+#endif // JOB_SYSTEM_H
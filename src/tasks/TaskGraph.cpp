@@ -0,0 +1,61 @@
+#include "TaskGraph.h"
+
+namespace Positional
+{
+	UInt32 TaskGraph::add(const TaskCallback &callback)
+	{
+		m_tasks.push_back(Task{callback, vector<UInt32>(), 0});
+		return m_tasks.size() - 1;
+	}
+
+	void TaskGraph::precede(const UInt32 &before, const UInt32 &after)
+	{
+		assert(before < m_tasks.size() && after < m_tasks.size() && before != after);
+		m_tasks[before].dependents.push_back(after);
+		m_tasks[after].dependencyCount++;
+	}
+
+	void TaskGraph::run(ITaskScheduler &scheduler)
+	{
+		const UInt32 taskCount = m_tasks.size();
+		m_remaining.resize(taskCount);
+		m_wave.clear();
+		for (UInt32 i = 0; i < taskCount; ++i)
+		{
+			m_remaining[i] = m_tasks[i].dependencyCount;
+			if (m_remaining[i] == 0)
+			{
+				m_wave.push_back(i);
+			}
+		}
+
+		UInt32 ran = 0;
+		while (!m_wave.empty())
+		{
+			scheduler.parallelFor(m_wave.size(), 1, [this](const UInt32 &begin, const UInt32 &end)
+			{
+				for (UInt32 i = begin; i < end; ++i)
+				{
+					m_tasks[m_wave[i]].callback();
+				}
+			});
+			ran += m_wave.size();
+
+			m_nextWave.clear();
+			for (const UInt32 &task : m_wave)
+			{
+				for (const UInt32 &dependent : m_tasks[task].dependents)
+				{
+					if (--m_remaining[dependent] == 0)
+					{
+						m_nextWave.push_back(dependent);
+					}
+				}
+			}
+			m_wave.swap(m_nextWave);
+		}
+
+		// a cycle leaves tasks behind
+		assert(ran == taskCount);
+	}
+}
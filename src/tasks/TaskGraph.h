@@ -0,0 +1,48 @@
+/*
+ * Tasks with dependencies, run in waves where each wave holds every task whose dependencies have finished
+ */
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "ITaskScheduler.h"
+#include <vector>
+
+using namespace std;
+
+namespace Positional
+{
+	typedef function<void()> TaskCallback;
+
+	class TaskGraph
+	{
+	private:
+		struct Task
+		{
+			TaskCallback callback;
+			vector<UInt32> dependents;
+			UInt32 dependencyCount;
+		};
+
+		vector<Task> m_tasks;
+		vector<UInt32> m_remaining;
+		vector<UInt32> m_wave;
+		vector<UInt32> m_nextWave;
+
+	public:
+		UInt32 add(const TaskCallback &callback);
+
+		/*
+		 * after does not start before before finished
+		 */
+		void precede(const UInt32 &before, const UInt32 &after);
+
+		/*
+		 * Blocks until every task ran, the graph can be run again
+		 */
+		void run(ITaskScheduler &scheduler);
+
+		inline UInt32 count() const { return m_tasks.size(); }
+		inline void clear() { m_tasks.clear(); }
+	};
+}
+#endif // TASK_GRAPH_H
@@ -0,0 +1,142 @@
+/*
+ * RigidBody::integrate and RigidBody::differentiate over a batch give the same bits as the per body code they replaced.
+ * Compilers contracting multiply-adds into fused instructions (-ffp-contract=fast with FMA) may round the scalar
+ * reference differently, build without that to compare.
+ * The old per body code is kept below as the reference, stepped next to the batch with forces, torques and clamped spin.
+ */
+#include "simulation/World.h"
+#include "simulation/RigidBody.h"
+#include <cstdio>
+
+using namespace std;
+using namespace Positional;
+
+/*
+ * Per body integration as it was before the batch kernels
+ */
+void integrate(Body &body, const Float &dt, const Vec3 &gravity)
+{
+	body.prePose = body.pose;
+	body.velocity.linear += dt * gravity + dt * body.invMass * body.forces.linear;
+	body.pose.position += dt * body.velocity.linear;
+
+	Vec3 dOmega = body.massPose.inverseRotate(body.pose.inverseRotate(body.forces.angular * dt));
+	dOmega.x *= body.invInertia.x;
+	dOmega.y *= body.invInertia.y;
+	dOmega.z *= body.invInertia.z;
+	dOmega = body.pose.rotate(body.massPose.rotate(dOmega));
+
+	body.velocity.angular += dOmega;
+	body.applyRotation(body.velocity.angular, dt);
+	body.forces.linear = Vec3::zero;
+	body.forces.angular = Vec3::zero;
+}
+
+/*
+ * Per body differentiation as it was before the batch kernels
+ */
+void differentiate(Body &body, const Float &dtInv)
+{
+	body.preVelocity = body.velocity;
+	body.velocity.linear = (body.pose.transform(body.massPose.position) - body.prePose.transform(body.massPose.position)) * dtInv;
+	const Quat dq = body.pose.rotation * body.prePose.rotation.inverse();
+	const Float dtInv2 = 2 * dtInv;
+	body.velocity.angular = dq.w >= 0 ?
+		Vec3(dq.x * dtInv2, dq.y * dtInv2, dq.z * dtInv2) :
+		Vec3(-dq.x * dtInv2, -dq.y * dtInv2, -dq.z * dtInv2);
+}
+
+bool same(const Vec3 &a, const Vec3 &b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool same(const Body &a, const Body &b)
+{
+	return same(a.pose.position, b.pose.position) &&
+		a.pose.rotation.x == b.pose.rotation.x && a.pose.rotation.y == b.pose.rotation.y &&
+		a.pose.rotation.z == b.pose.rotation.z && a.pose.rotation.w == b.pose.rotation.w &&
+		same(a.velocity.linear, b.velocity.linear) && same(a.velocity.angular, b.velocity.angular) &&
+		same(a.preVelocity.linear, b.preVelocity.linear) && same(a.preVelocity.angular, b.preVelocity.angular);
+}
+
+int main()
+{
+	const Float dt = 1.0 / 240.0;
+	const Vec3 gravity(0, -9.81, 0);
+
+	// a count that leaves a partly filled lane group for any width
+	World world(0);
+	vector<Ref<Body>> bodies;
+	for (int i = 0; i < 13; ++i)
+	{
+		Ref<Body> body = world.createBody<RigidBody>(Vec3(i, 0.1 * i, -0.3 * i), Quat::fromAngleAxis(0.4 * i, Vec3(1, 2, 3).normalize()));
+		world.createCollider<BoxCollider>(body, Vec3::zero, Quat::identity, 1, 0.5, 0.5, 0, Vec3(0.5, 0.2 + 0.05 * i, 0.3));
+		// off center, so the mass pose is neither at the origin nor aligned
+		world.createCollider<SphereCollider>(body, Vec3(0.4, 0.1 * i, 0), Quat::identity, 3, 0.5, 0.5, 0, (Float)0.25);
+
+		Body &b = body.get();
+		b.velocity.linear = Vec3(0.5 * i, -1 + 0.2 * i, 0.3);
+		// the last bodies spin fast enough to be clamped
+		b.velocity.angular = Vec3(0.7, -0.2 * i, 0.1 * i) * (i < 10 ? 1 : 200);
+		if (i % 3 == 0)
+		{
+			b.applyForce(Vec3(2, 30, -1) * i);
+		}
+		if (i % 4 == 1)
+		{
+			b.applyTorque(Vec3(-3, 1, 5) * i);
+		}
+		bodies.push_back(body);
+	}
+
+	vector<Body> expected;
+	vector<Body *> batch;
+	for (const Ref<Body> &body : bodies)
+	{
+		expected.push_back(body.get());
+		batch.push_back(&body.get());
+	}
+
+	int failures = 0;
+	for (int substep = 0; substep < 4; ++substep)
+	{
+		RigidBody::integrate(batch.data(), batch.size(), dt, gravity);
+		for (Body &body : expected)
+		{
+			integrate(body, dt, gravity);
+		}
+
+		// stands in for the solver moving the bodies
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			const Vec3 correction(0.001 * i, -0.002, 0.0005 * substep);
+			batch[i]->applyCorrection(correction, batch[i]->pose.position + Vec3(0.1, 0.2, 0));
+			expected[i].applyCorrection(correction, expected[i].pose.position + Vec3(0.1, 0.2, 0));
+		}
+
+		RigidBody::differentiate(batch.data(), batch.size(), 1 / dt);
+		for (Body &body : expected)
+		{
+			differentiate(body, 1 / dt);
+		}
+
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			if (!same(*batch[i], expected[i]))
+			{
+				printf("FAIL substep %d, body %zu differs from the per body code\n", substep, i);
+				failures++;
+			}
+		}
+	}
+
+	if (failures > 0)
+	{
+		printf("%d mismatches\n", failures);
+		return 1;
+	}
+
+	printf("passed\n");
+	return 0;
+}
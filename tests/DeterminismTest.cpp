@@ -0,0 +1,96 @@
+/*
+ * World::deterministic gives the same state hash for any worker count and from run to run.
+ * Runs on 1, 3 and 7 workers are compared against the inline run, with and without wide contacts.
+ */
+#include "simulation/World.h"
+#include "simulation/RigidBody.h"
+#include "constraints/GenericJointConstraint.h"
+#include <cstdio>
+
+using namespace std;
+using namespace Positional;
+
+/*
+ * Stacks of boxes with gaps from destroyed bodies, spheres falling onto them and a chain of jointed capsules
+ */
+UInt64 simulate(const UInt32 &workers, const bool &wideContacts)
+{
+	World world(workers);
+	world.deterministic = true;
+	world.wideContacts = wideContacts;
+	world.parallelThreshold = 0;
+	world.sleepTime = 0.5;
+	world.gravity = Vec3(0, -9.81, 0);
+	world.createCollider<BoxCollider>(Body::null, Vec3(0, -1, 0), Quat::identity, 1, 0.5, 0.5, 0, Vec3(100, 1, 100));
+
+	vector<Ref<Body>> boxes;
+	for (int x = 0; x < 6; ++x)
+	{
+		for (int z = 0; z < 6; ++z)
+		{
+			for (int y = 0; y < 3; ++y)
+			{
+				Ref<Body> box = world.createBody<RigidBody>(Vec3(x * 1.02, 0.6 + y * 1.1, z * 1.02 + 0.01 * y), Quat::fromAngleAxis(0.05 * y, Vec3(0, 1, 0)));
+				world.createCollider<BoxCollider>(box, Vec3::zero, Quat::identity, 1, 0.5, 0.5, 0, Vec3(0.5, 0.5, 0.5));
+				boxes.push_back(box);
+			}
+		}
+	}
+
+	for (int i = 0; i < 8; ++i)
+	{
+		world.destroyBody(boxes[i * 13]);
+	}
+
+	for (int i = 0; i < 10; ++i)
+	{
+		Ref<Body> sphere = world.createBody<RigidBody>(Vec3(i * 0.55, 5 + 0.3 * i, 2.5), Quat::identity);
+		world.createCollider<SphereCollider>(sphere, Vec3::zero, Quat::identity, 2, 0.5, 0.5, 0.2, (Float)0.3);
+	}
+
+	Ref<Body> previous = Body::null;
+	for (int i = 0; i < 8; ++i)
+	{
+		const Vec3 pivot(-3 + 0.6 * i, 6, 0);
+		Ref<Body> link = world.createBody<RigidBody>(pivot + Vec3(0.3, 0, 0), Quat::fromAngleAxis(Math::Pi / 2, Vec3(0, 0, 1)));
+		world.createCollider<CapsuleCollider>(link, Vec3::zero, Quat::identity, 1, 0.5, 0.5, 0, (Float)0.1, (Float)0.2);
+		const Pose frameA = previous.valid() ? Pose(previous.get().pose.inverseTransform(pivot), previous.get().pose.rotation.conjugate()) : Pose(pivot, Quat::identity);
+		const Pose frameB(link.get().pose.inverseTransform(pivot), link.get().pose.rotation.conjugate());
+		world.createConstraint<GenericJointConstraint, GenericJointConstraint::Data>(previous, link, true, frameA, frameB,
+			(UInt8)(DOF::Swing | DOF::Twist), (UInt8)0, (Float)0, (Float)0, (Float)0, (Float)0, (Float)0, (Float)0, (Float)0, (Float)0, (Float)0);
+		previous = link;
+	}
+
+	for (int i = 0; i < 60; ++i)
+	{
+		world.simulate(1.0 / 60.0, 4);
+	}
+	return world.stateHash();
+}
+
+int main()
+{
+	int failures = 0;
+	for (const bool wideContacts : {false, true})
+	{
+		const UInt64 expected = simulate(0, wideContacts);
+		for (const UInt32 workers : {0u, 1u, 3u, 7u})
+		{
+			const UInt64 hash = simulate(workers, wideContacts);
+			if (hash != expected)
+			{
+				printf("FAIL wide contacts %d, %u workers: hash %016llx, expected %016llx\n", (int)wideContacts, workers, (unsigned long long)hash, (unsigned long long)expected);
+				failures++;
+			}
+		}
+	}
+
+	if (failures > 0)
+	{
+		printf("%d of 8 runs differ\n", failures);
+		return 1;
+	}
+
+	printf("passed\n");
+	return 0;
+}
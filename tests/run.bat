@@ -0,0 +1,29 @@
+@echo off
+rem Builds every test in this folder against the engine sources and runs it, from a Visual Studio developer prompt.
+rem Exits with the number of tests that failed to build or returned non-zero.
+setlocal enabledelayedexpansion
+set root=%~dp0..
+set out=%~dp0build
+set flags=/nologo /std:c++17 /O2 /EHsc /W3 /I"%root%\src"
+if not exist "%out%\engine" mkdir "%out%\engine"
+
+rem the engine is compiled once into a library every test links against
+if exist "%out%\sources.rsp" del "%out%\sources.rsp"
+for /r "%root%\src" %%f in (*.cpp) do echo "%%f">> "%out%\sources.rsp"
+cl %flags% /MP /c /Fo"%out%\engine\\" @"%out%\sources.rsp" || exit /b 1
+lib /nologo /out:"%out%\Positional.lib" "%out%\engine\*.obj" || exit /b 1
+
+set failed=0
+for %%t in ("%~dp0*.cpp") do (
+	echo == %%~nt
+	cl %flags% /Fo"%out%\%%~nt.obj" /Fe"%out%\%%~nt.exe" "%%~ft" "%out%\Positional.lib"
+	if errorlevel 1 (
+		set /a failed+=1
+	) else (
+		"%out%\%%~nt.exe"
+		if errorlevel 1 set /a failed+=1
+	)
+)
+
+if %failed% neq 0 echo %failed% test^(s^) failed
+exit /b %failed%